@@ -0,0 +1,102 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include "pFactory.h"
+
+// In this example, threads share clauses (sequences of int of various sizes) as a parallel SAT solver does.
+// This benchmark compares an ArenaCommunicator<int> (records stored contiguously in recycled segments)
+// with a Communicator<std::vector<int>> (a deque of vectors allocated on the heap).
+
+static const unsigned int nbClauses = 20000;
+
+// The clause number i of a thread: between 2 and 41 literals
+inline void makeClause(unsigned int threadId, unsigned int i, std::vector<int>& clause){
+    clause.clear();
+    for (unsigned int j = 0; j < 2 + (i * 7 + threadId) % 40; j++) clause.push_back((int)(i + j) * ((j & 1) ? -1 : 1));
+}
+
+double withArena(unsigned int nbThreads, uint64_t& nbLiterals, uint64_t& nbAllocations){
+    pFactory::Group group(nbThreads);
+    pFactory::ArenaCommunicator<int> communicator(group);
+    std::vector<uint64_t> literals(nbThreads, 0);
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            std::vector<int> clause;
+            uint64_t& nb = literals[group.getThreadId()];
+            for (unsigned int j = 0; j < nbClauses; j++){
+                makeClause(group.getThreadId(), j, clause);
+                communicator.send(clause);
+                if (j % 100 == 0) communicator.recvAll([&](const int*, std::size_t size){nb += size;}); // Read in place
+            }
+            group.barrier.wait();
+            communicator.recvAll([&](const int*, std::size_t size){nb += size;});
+            return 0;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    group.start();
+    group.wait();
+    nbLiterals = 0;
+    for (uint64_t nb : literals) nbLiterals += nb;
+    nbAllocations = communicator.getNbAllocations();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double withCommunicator(unsigned int nbThreads, uint64_t& nbLiterals){
+    pFactory::Group group(nbThreads);
+    pFactory::Communicator<std::vector<int>> communicator(group);
+    std::vector<uint64_t> literals(nbThreads, 0);
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            std::vector<int> clause;
+            std::vector<std::vector<int>> clauses;
+            uint64_t& nb = literals[group.getThreadId()];
+            for (unsigned int j = 0; j < nbClauses; j++){
+                makeClause(group.getThreadId(), j, clause);
+                communicator.send(clause);
+                if (j % 100 == 0){
+                    clauses.clear();
+                    communicator.recvAll(clauses);
+                    for (std::vector<int>& c : clauses) nb += c.size();
+                }
+            }
+            group.barrier.wait();
+            clauses.clear();
+            communicator.recvAll(clauses);
+            for (std::vector<int>& c : clauses) nb += c.size();
+            return 0;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    group.start();
+    group.wait();
+    nbLiterals = 0;
+    for (uint64_t nb : literals) nbLiterals += nb;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    for (unsigned int nbThreads = 2; nbThreads <= std::max(2u, pFactory::getNbCores()); nbThreads *= 2){
+        uint64_t literalsArena = 0, literalsCommunicator = 0, allocations = 0;
+        double timeArena = withArena(nbThreads, literalsArena, allocations);
+        double timeCommunicator = withCommunicator(nbThreads, literalsCommunicator);
+        std::cout << "threads: " << nbThreads 
+            << " - ArenaCommunicator: " << timeArena << "s (literals: " << literalsArena << ", segments allocated: " << allocations << ")"
+            << " - Communicator: " << timeCommunicator << "s (literals: " << literalsCommunicator << ")" << std::endl;
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include "pFactory.h"
+
+// In this example, the threads of a group call barrier.wait() in a loop, as between the rounds of sharing of a solver.
+// The latency of a generation (the time per call of wait()) of a pFactory::Barrier is compared with a central barrier
+// (a mutex and a condition variable, where all threads update the same counter and are woken up under the same mutex)
+// from 2 to 128 threads. Each generation must have exactly one last arriver.
+
+// A barrier with a central counter
+class CentralBarrier
+{
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    unsigned int nbThreads;
+    unsigned int tmpNbThreads;
+    unsigned int nbGenerations;
+
+public:
+    explicit CentralBarrier(unsigned int p_nbThreads) : nbThreads(p_nbThreads), tmpNbThreads(p_nbThreads), nbGenerations(0) {}
+
+    bool wait(){
+        std::unique_lock<std::mutex> lock{m};
+        unsigned int tmpNbGenerations = nbGenerations;
+        if (--tmpNbThreads == 0){
+            nbGenerations++;
+            tmpNbThreads = nbThreads;
+            cv.notify_all();
+            return true;
+        }
+        cv.wait(lock, [&tmpNbGenerations, this]{return tmpNbGenerations != nbGenerations;});
+        return false;
+    }
+};
+
+template <class B>
+double latency(unsigned int nbThreads, unsigned int nbGenerations, bool& oneLastArriver){
+    pFactory::Group group(nbThreads);
+    B barrier(nbThreads);
+    std::atomic<unsigned int> nbLastArrivers(0);
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            barrier.wait(); // All threads are started
+            for (unsigned int generation = 0; generation < nbGenerations; generation++)
+                if (barrier.wait()) nbLastArrivers++;
+            return 0;
+        });
+    }
+    group.start();
+    auto start = std::chrono::steady_clock::now();
+    group.wait();
+    oneLastArriver = nbLastArrivers == nbGenerations;
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / nbGenerations;
+}
+
+int main() {
+    bool correct = true;
+    std::cout << "cores: " << pFactory::getNbCores() << std::endl;
+    for (unsigned int nbThreads = 2; nbThreads <= 128; nbThreads *= 2){
+        const unsigned int nbGenerations = std::max(50u, 20000 / nbThreads);
+        bool treeCorrect = false, centralCorrect = false;
+        const double tree = latency<pFactory::Barrier>(nbThreads, nbGenerations, treeCorrect);
+        const double central = latency<CentralBarrier>(nbThreads, nbGenerations, centralCorrect);
+        correct = correct && treeCorrect && centralCorrect;
+        std::cout << "threads: " << nbThreads << " - pFactory::Barrier: " << tree << " us - central barrier: " << central << " us"
+            << (treeCorrect ? "" : " (wrong number of last arrivers)") << std::endl;
+    }
+    return correct ? 0 : 1;
+}
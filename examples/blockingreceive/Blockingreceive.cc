@@ -0,0 +1,84 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include "pFactory.h"
+
+// In this example, a thread sends timestamps to helper threads (e.g. verifiers) that have nothing else to do.
+// The helpers sleep in recvWait() instead of polling the communicator and we measure the send-to-wakeup latency.
+// For comparison, the same measure is done with helpers that poll recv() and sleep 1ms between two tries.
+
+static const unsigned int nbMessages = 1000;
+
+inline int64_t now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void measure(unsigned int nbHelpers, bool blocking){
+    pFactory::Group group(1 + nbHelpers);
+    // The thread 0 sends, the others receive
+    std::vector<bool> senders(1 + nbHelpers, false), receivers(1 + nbHelpers, true);
+    senders[0] = true;
+    receivers[0] = false;
+    pFactory::Communicator<int64_t> communicator(group, senders, receivers);
+    std::vector<std::vector<int64_t>> latencies(1 + nbHelpers);
+
+    for (unsigned int i = 0; i <= nbHelpers; i++) {
+        group.add([&]() {
+            if (group.getThreadId() == 0){  // The sender
+                for (unsigned int j = 0; j < nbMessages; j++){
+                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                    communicator.send(now());
+                }
+                return 0;
+            }
+            // The helpers
+            std::vector<int64_t>& latency = latencies[group.getThreadId()];
+            int64_t sent;
+            while (latency.size() < nbMessages){
+                if (blocking){
+                    if (!communicator.recvWait(sent, std::chrono::seconds(1))) break;
+                }else if (!communicator.recv(sent)){
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                latency.push_back(now() - sent);
+            }
+            return 0;
+        });
+    }
+    group.start();
+    group.wait();
+
+    std::vector<int64_t> all;
+    for (std::vector<int64_t>& latency : latencies) all.insert(all.end(), latency.begin(), latency.end());
+    std::sort(all.begin(), all.end());
+    if (all.empty()) return;
+    std::cout << "helpers: " << nbHelpers << " - " << (blocking ? "recvWait()" : "polling   ")
+        << " - received: " << all.size() << "/" << nbHelpers * nbMessages
+        << " - latency median: " << all[all.size() / 2] / 1000 << "us"
+        << " - 99th: " << all[all.size() * 99 / 100] / 1000 << "us"
+        << " - max: " << all.back() / 1000 << "us" << std::endl;
+}
+
+int main() {
+    for (unsigned int nbHelpers = 1; nbHelpers <= std::max(1u, pFactory::getNbCores() - 1); nbHelpers *= 2){
+        measure(nbHelpers, true);
+        measure(nbHelpers, false);
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "pFactory.h"
+
+// In this example, the queue of each sender is bounded to 100 integers.
+// The thread 0 is a slow receiver: with the OverflowPolicy::dropOldest policy,
+// the integers that it has not received in time are dropped (only for it).
+// Thus, the memory used by the communicator stays flat regardless of the speed of the receivers.
+
+int main() {
+    unsigned int nbThreads = 4;
+    unsigned int nbData = 10000;
+    pFactory::Group group(nbThreads);
+    pFactory::Communicator<int> integerCommunicator(group);
+
+    // At most 100 integers are kept per sender
+    integerCommunicator.setCapacity(100, pFactory::OverflowPolicy::dropOldest);
+
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            std::vector<int> data;
+            unsigned int nbReceived = 0;
+            for(unsigned int j = 0; j < nbData; j++) {
+                integerCommunicator.send(j);
+                // The thread 0 receives 100 times less often than the others
+                if (j % (group.getThreadId() == 0 ? 1000 : 10) == 0){
+                    data.clear();
+                    integerCommunicator.recvAll(data);
+                    nbReceived += data.size();
+                }
+            }
+            group.barrier.wait();
+            data.clear();
+            integerCommunicator.recvAll(data);
+            nbReceived += data.size();
+
+            // Each integer sent by the others is either received or dropped
+            pFactory::cout() << "Thread " << group.getThreadId() << " received: " << nbReceived 
+                << " dropped: " << integerCommunicator.getNbDropped(group.getThreadId()) << std::endl;
+            return 0;
+        });
+    }
+    // Start the computation of all tasks
+    group.start();
+    // Wait until all threads are performed all tasks 
+    group.wait();
+}
@@ -0,0 +1,91 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include "pFactory.h"
+
+// In this example, threads solve a minimization problem and share their bounds.
+// Each thread checks the best bound at each step of its search and sometimes finds a better one.
+// This benchmark compares a BoundRegister with the sharing of all bounds through a Communicator
+// (where a thread drains the whole history to learn one number).
+
+static const unsigned int nbSteps = 200000;
+
+// A new bound of a thread is found every 100 steps
+inline bool newBound(unsigned int step){return step % 100 == 0;}
+inline int boundValue(unsigned int threadId, unsigned int step){return (int)(nbSteps - step) * 64 + (int)threadId;}
+
+double withBoundRegister(unsigned int nbThreads, int& best){
+    pFactory::Group group(nbThreads);
+    pFactory::BoundRegister<int> bound(INT_MAX);
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            uint64_t version = 0;
+            int localBound = INT_MAX;
+            for (unsigned int step = 0; step < nbSteps; step++){
+                if (bound.hasChanged(version)) localBound = bound.get();  // Cheap check at each step
+                if (newBound(step) && boundValue(group.getThreadId(), step) < localBound) bound.improve(boundValue(group.getThreadId(), step));
+            }
+            return 0;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    group.start();
+    group.wait();
+    best = bound.get();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double withCommunicator(unsigned int nbThreads, int& best){
+    pFactory::Group group(nbThreads);
+    pFactory::Communicator<int> communicator(group);
+    std::vector<int> bests(nbThreads, INT_MAX);
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            std::vector<int> bounds;
+            int localBound = INT_MAX;
+            for (unsigned int step = 0; step < nbSteps; step++){
+                bounds.clear();
+                communicator.recvAll(bounds);  // Drain the history of bounds at each step
+                for (int value : bounds) localBound = std::min(localBound, value);
+                if (newBound(step) && boundValue(group.getThreadId(), step) < localBound){
+                    localBound = boundValue(group.getThreadId(), step);
+                    communicator.send(localBound);
+                }
+            }
+            bests[group.getThreadId()] = localBound;
+            return 0;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    group.start();
+    group.wait();
+    best = *std::min_element(bests.begin(), bests.end());
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    for (unsigned int nbThreads = 2; nbThreads <= std::max(2u, pFactory::getNbCores()); nbThreads *= 2){
+        int bestRegister = 0, bestCommunicator = 0;
+        double timeRegister = withBoundRegister(nbThreads, bestRegister);
+        double timeCommunicator = withCommunicator(nbThreads, bestCommunicator);
+        std::cout << "threads: " << nbThreads 
+            << " - BoundRegister: " << timeRegister << "s (best: " << bestRegister << ")"
+            << " - Communicator: " << timeCommunicator << "s (best: " << bestCommunicator << ")" << std::endl;
+    }
+}
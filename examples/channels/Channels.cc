@@ -0,0 +1,108 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "pFactory.h"
+
+// In this example, each thread shares units (int), clauses (std::vector<int>) and bounds (long) at each step.
+// With one communicator per kind of data, a sharing point browses the queues (and takes their locks) three times.
+// With a ChannelCommunicator, the three channels share the queues: one browse for all of them. The bounds and the
+// units have a higher priority than the clauses: their handlers are called first.
+
+static const unsigned int nbSteps = 2000;
+
+enum {units, clauses, bounds};
+
+int main() {
+    const unsigned int nbThreads = std::max(4u, pFactory::getNbCores());
+    std::atomic<unsigned int> nbErrors(0);
+
+    // Three communicators
+    pFactory::Group group1(nbThreads);
+    pFactory::Communicator<int> unitCommunicator(group1);
+    pFactory::Communicator<std::vector<int>> clauseCommunicator(group1);
+    pFactory::Communicator<long> boundCommunicator(group1);
+    for (unsigned int i = 0; i < nbThreads; i++) {
+        group1.add([&]() {
+            const unsigned int threadId = group1.getThreadId();
+            std::vector<int> receivedUnits;
+            std::vector<std::vector<int>> receivedClauses;
+            std::vector<long> receivedBounds;
+            group1.barrier.wait();
+            for (unsigned int step = 0; step < nbSteps; step++){
+                unitCommunicator.send((int)(threadId * nbSteps + step));
+                clauseCommunicator.send(std::vector<int>{(int)threadId, -(int)step, (int)step + 1});
+                boundCommunicator.send((long)step);
+                unitCommunicator.recvAll(receivedUnits);
+                clauseCommunicator.recvAll(receivedClauses);
+                boundCommunicator.recvAll(receivedBounds);
+                std::this_thread::yield(); // To interleave the threads on a small machine
+            }
+            group1.barrier.wait();
+            unitCommunicator.recvAll(receivedUnits);
+            clauseCommunicator.recvAll(receivedClauses);
+            boundCommunicator.recvAll(receivedBounds);
+            if (receivedUnits.size() != (nbThreads - 1) * nbSteps || receivedClauses.size() != (nbThreads - 1) * nbSteps
+                || receivedBounds.size() != (nbThreads - 1) * nbSteps) nbErrors++;
+            return 0;
+        });
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    group1.start();
+    group1.wait();
+    const double seconds1 = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // One communicator with three channels
+    pFactory::Group group2(nbThreads);
+    pFactory::ChannelCommunicator<int, std::vector<int>, long> communicator(group2);
+    communicator.setPriority(bounds, 2);
+    communicator.setPriority(units, 1);
+    for (unsigned int i = 0; i < nbThreads; i++) {
+        group2.add([&]() {
+            const unsigned int threadId = group2.getThreadId();
+            unsigned int nbUnits = 0, nbClauses = 0, nbBounds = 0, nbWrongOrders = 0;
+            int last = bounds; // The channel of the last data handled in a recvAll()
+            std::function<void(int&)> onUnit = [&](int&){nbUnits++; if (last == clauses) nbWrongOrders++; last = units;};
+            std::function<void(std::vector<int>&)> onClause = [&](std::vector<int>&){nbClauses++; last = clauses;};
+            std::function<void(long&)> onBound = [&](long&){nbBounds++; if (last != bounds) nbWrongOrders++; last = bounds;};
+            group2.barrier.wait();
+            for (unsigned int step = 0; step <= nbSteps; step++){
+                if (step < nbSteps){
+                    communicator.send<units>((int)(threadId * nbSteps + step));
+                    communicator.send<clauses>(std::vector<int>{(int)threadId, -(int)step, (int)step + 1});
+                    communicator.send<bounds>((long)step);
+                }else group2.barrier.wait(); // The last recvAll() gets all remaining data
+                last = bounds;
+                communicator.recvAll(onUnit, onClause, onBound);
+                std::this_thread::yield();
+            }
+            if (nbUnits != (nbThreads - 1) * nbSteps || nbClauses != (nbThreads - 1) * nbSteps || nbBounds != (nbThreads - 1) * nbSteps
+                || nbWrongOrders) nbErrors++;
+            return 0;
+        });
+    }
+    start = std::chrono::steady_clock::now();
+    group2.start();
+    group2.wait();
+    const double seconds2 = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "three communicators: " << seconds1 << " s" << std::endl;
+    std::cout << "one communicator with three channels: " << seconds2 << " s" << std::endl;
+    std::cout << "data received - units: " << communicator.getNbChannelRecv(units) << " - clauses: " << communicator.getNbChannelRecv(clauses)
+        << " - bounds: " << communicator.getNbChannelRecv(bounds) << std::endl;
+    std::cout << "errors: " << nbErrors << std::endl;
+    return nbErrors ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include "pFactory.h"
+
+// In this example, threads share sorted clauses through an ArenaCommunicator with different codecs.
+// For each codec, we report the bytes saved by the encoding, the time of the sharing
+// and the cost of the decoding (measured by one thread that decodes the same clauses many times).
+// The DeltaBitPackCodec is measured with its AVX2 unpacking (used when the processor has it) and with its scalar one.
+// First, the delta codecs are checked on unsigned values.
+
+static const unsigned int nbClauses = 20000;
+
+// The clause number i of a thread: between 2 and 41 sorted literals over 10000 variables
+inline void makeClause(unsigned int threadId, unsigned int i, std::vector<int>& clause){
+    clause.clear();
+    unsigned int seed = i * 2654435761u + threadId;
+    for (unsigned int j = 0; j < 2 + (i * 7 + threadId) % 40; j++){
+        seed = seed * 1103515245u + 12345u;
+        int variable = 1 + (int)((seed >> 8) % 10000);
+        clause.push_back((seed & 1) ? variable : -variable);
+    }
+    std::sort(clause.begin(), clause.end());
+}
+
+template <class Codec>
+void measure(const char* name, unsigned int nbThreads){
+    pFactory::Group group(nbThreads);
+    pFactory::ArenaCommunicator<int, Codec> communicator(group);
+    std::vector<uint64_t> literals(nbThreads, 0);
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            std::vector<int> clause;
+            uint64_t& nb = literals[group.getThreadId()];
+            for (unsigned int j = 0; j < nbClauses; j++){
+                makeClause(group.getThreadId(), j, clause);
+                communicator.send(clause);
+                if (j % 100 == 0) communicator.recvAll([&](const int*, std::size_t size){nb += size;});
+            }
+            group.barrier.wait();
+            communicator.recvAll([&](const int*, std::size_t size){nb += size;});
+            return 0;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    group.start();
+    group.wait();
+    double timeSharing = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Decoding cost: encode the clauses of a thread once, decode them 20 times
+    Codec codec;
+    std::vector<uint8_t> encoded;
+    std::vector<std::pair<std::size_t, std::pair<std::size_t, std::size_t>>> records; // position, bytes, size
+    std::vector<int> clause;
+    uint64_t nbLiterals = 0;
+    for (unsigned int j = 0; j < nbClauses; j++){
+        makeClause(0, j, clause);
+        std::size_t position = encoded.size();
+        encoded.resize(position + codec.maxEncodedSize(clause.size()));
+        std::size_t bytes = codec.encode(clause.data(), clause.size(), &encoded[position]);
+        encoded.resize(position + bytes);
+        records.push_back(std::make_pair(position, std::make_pair(bytes, clause.size())));
+        nbLiterals += clause.size();
+    }
+    std::vector<int> decoded(64);
+    bool correct = true;
+    for (unsigned int j = 0; j < nbClauses; j++){
+        makeClause(0, j, clause);
+        codec.decode(&encoded[records[j].first], records[j].second.first, records[j].second.second, decoded.data());
+        if (!std::equal(clause.begin(), clause.end(), decoded.begin())) correct = false;
+    }
+    int64_t checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for (unsigned int k = 0; k < 20; k++)
+        for (auto& record : records){
+            codec.decode(&encoded[record.first], record.second.first, record.second.second, decoded.data());
+            checksum += decoded[0];
+        }
+    double timeDecode = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t nbReceived = 0;
+    for (uint64_t nb : literals) nbReceived += nb;
+    std::cout << "threads: " << nbThreads << " - " << name
+        << " - bytes: " << communicator.getNbEncodedBytes() << "/" << communicator.getNbRawBytes()
+        << " (saved: " << 100 - 100 * communicator.getNbEncodedBytes() / communicator.getNbRawBytes() << "%)"
+        << " - sharing: " << timeSharing << "s (literals received: " << nbReceived << ")"
+        << " - decode: " << timeDecode * 1e9 / (20 * nbLiterals) << "ns/literal (checksum: " << checksum << ")"
+        << (correct ? "" : " - WRONG DECODING") << std::endl;
+}
+
+// Encode then decode unsorted values of an unsigned type in [0, bound] (their differences are negative as well as positive)
+template <class Codec, class T>
+bool roundTrip(const char* name, T bound = std::numeric_limits<T>::max()){
+    std::vector<T> values = {5, 0, 7, 3, bound, 0, 1, (T)(bound / 2)};
+    for (unsigned int i = 0; i < 100; i++) values.push_back((T)(i * 2654435761u % ((uint64_t)bound + 1)));
+    Codec codec;
+    std::vector<uint8_t> encoded(codec.maxEncodedSize(values.size()));
+    const std::size_t bytes = codec.encode(values.data(), values.size(), encoded.data());
+    std::vector<T> decoded(values.size());
+    codec.decode(encoded.data(), bytes, values.size(), decoded.data());
+    const bool correct = decoded == values;
+    std::cout << name << " round trip: " << (correct ? "correct" : "incorrect") << std::endl;
+    return correct;
+}
+
+int main() {
+    bool correct = roundTrip<pFactory::DeltaVarintCodec<unsigned int>, unsigned int>("DeltaVarintCodec<unsigned int>   ");
+    correct &= roundTrip<pFactory::DeltaVarintCodec<unsigned short>, unsigned short>("DeltaVarintCodec<unsigned short> ");
+    correct &= roundTrip<pFactory::DeltaBitPackCodec<unsigned int, false>, unsigned int>("DeltaBitPackCodec<unsigned int> (scalar)");
+    correct &= roundTrip<pFactory::DeltaBitPackCodec<unsigned int>, unsigned int>("DeltaBitPackCodec<unsigned int>  ");
+    //Small differences: the AVX2 unpacking (at most 25 bits)
+    correct &= roundTrip<pFactory::DeltaBitPackCodec<unsigned int>, unsigned int>("DeltaBitPackCodec<unsigned int> (AVX2)", 1 << 20);
+    for (unsigned int nbThreads = 2; nbThreads <= std::max(2u, pFactory::getNbCores()); nbThreads *= 2){
+        measure<pFactory::RawCodec<int>>("RawCodec                  ", nbThreads);
+        measure<pFactory::DeltaVarintCodec<int>>("DeltaVarintCodec          ", nbThreads);
+        measure<pFactory::DeltaBitPackCodec<int, false>>("DeltaBitPackCodec (scalar)", nbThreads);
+        measure<pFactory::DeltaBitPackCodec<int>>("DeltaBitPackCodec         ", nbThreads);
+    }
+    return correct ? 0 : 1;
+}
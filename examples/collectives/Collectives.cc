@@ -0,0 +1,126 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include "pFactory.h"
+
+// In this example, the threads of a group combine their statistics at each round of a search: the best bound (min),
+// the total number of conflicts (sum) and a vote on a restart (a structure with its own operator). They also gather the
+// bounds of all threads, receive the parameters of the thread 1 (broadcast) and overlap a reduction with their work
+// (non-blocking allreduce polled with test()). The order of the threads is checked with a non-commutative operator
+// (the concatenation of ranges of threads). Then the time of an allreduce is compared with a Communicator and a barrier.
+
+static const unsigned int nbRounds = 1000;
+
+struct Vote
+{
+    unsigned int nbRestarts;
+    unsigned int minLbd;
+};
+
+struct Range // The threads [first, last]
+{
+    unsigned int first;
+    unsigned int last;
+    bool ordered;
+};
+
+int main() {
+    const unsigned int nbThreads = std::max(6u, pFactory::getNbCores());
+    pFactory::Group group(nbThreads);
+    std::atomic<unsigned int> nbErrors(0);
+    std::atomic<uint64_t> nbPolls(0);
+
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            const unsigned int threadId = group.getThreadId();
+            std::vector<int> bounds;
+            for (unsigned int round = 0; round < nbRounds; round++){
+                const int bound = (int)((threadId * 7 + round * 13) % 101);
+                const uint64_t nbConflicts = threadId + round;
+                const Vote vote = {threadId % 2 == 0 ? 1u : 0u, 2 + (threadId + round) % 5};
+
+                const int best = group.allreduce(bound, [](int a, int b){return std::min(a, b);});
+                const uint64_t total = group.allreduce(nbConflicts, [](uint64_t a, uint64_t b){return a + b;});
+                const Vote votes = group.allreduce(vote, [](const Vote& a, const Vote& b){return Vote{a.nbRestarts + b.nbRestarts, std::min(a.minLbd, b.minLbd)};});
+                const Range range = group.allreduce(Range{threadId, threadId, true}, [](const Range& a, const Range& b){
+                    return Range{a.first, b.last, a.ordered && b.ordered && a.last + 1 == b.first};
+                });
+                group.allgather(bound, bounds);
+                const unsigned int seed = group.broadcast(threadId == 1 ? round * 3 : 0u, 1);
+                const uint64_t sum = group.reduce(nbConflicts, [](uint64_t a, uint64_t b){return a + b;}, nbThreads - 1);
+
+                // Overlap a reduction with some work
+                auto request = group.iallreduce(bound, [](int a, int b){return std::max(a, b);});
+                while (!request.test()){
+                    nbPolls++;
+                    std::this_thread::yield(); // Some work between two polls
+                }
+                const int worst = request.get();
+
+                int expectedBest = INT_MAX, expectedWorst = INT_MIN;
+                for (unsigned int j = 0; j < nbThreads; j++){
+                    const int value = (int)((j * 7 + round * 13) % 101);
+                    expectedBest = std::min(expectedBest, value);
+                    expectedWorst = std::max(expectedWorst, value);
+                    if (bounds[j] != value) nbErrors++;
+                }
+                const uint64_t expectedTotal = (uint64_t)nbThreads * (nbThreads - 1) / 2 + (uint64_t)nbThreads * round;
+                if (best != expectedBest || worst != expectedWorst || total != expectedTotal) nbErrors++;
+                if (votes.nbRestarts != (nbThreads + 1) / 2 || votes.minLbd != 2) nbErrors++;
+                if (!range.ordered || range.first != 0 || range.last != nbThreads - 1) nbErrors++;
+                if (seed != round * 3) nbErrors++;
+                if (threadId == nbThreads - 1 && sum != expectedTotal) nbErrors++;
+            }
+            return 0;
+        });
+    }
+    group.start();
+    group.wait();
+    std::cout << "rounds: " << nbRounds << " - errors: " << nbErrors << " - polls of the non-blocking allreduce: " << nbPolls << std::endl;
+
+    // The sum of one value per thread: allreduce against a Communicator and a barrier
+    for (unsigned int withCommunicator = 0; withCommunicator < 2; withCommunicator++){
+        pFactory::Group benchmark(nbThreads);
+        pFactory::Communicator<uint64_t> communicator(benchmark);
+        for(unsigned int i = 0; i < nbThreads; i++) {
+            benchmark.add([&]() {
+                std::vector<uint64_t> data;
+                for (unsigned int round = 0; round < nbRounds; round++){
+                    uint64_t total = round;
+                    if (withCommunicator){
+                        communicator.send(round);
+                        benchmark.barrier.wait(); // All values are sent
+                        data.clear();
+                        communicator.recvAll(data);
+                        for (uint64_t value : data) total += value;
+                        benchmark.barrier.wait(); // All values are received
+                    }else total = benchmark.allreduce(total, [](uint64_t a, uint64_t b){return a + b;});
+                    if (total != (uint64_t)nbThreads * round) nbErrors++;
+                }
+                return 0;
+            });
+        }
+        auto start = std::chrono::steady_clock::now();
+        benchmark.start();
+        benchmark.wait();
+        const double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        std::cout << (withCommunicator ? "Communicator + barrier: " : "allreduce: ") << microseconds / nbRounds << " us per sum" << std::endl;
+    }
+    return nbErrors == 0 ? 0 : 1;
+}
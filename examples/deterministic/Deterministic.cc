@@ -0,0 +1,107 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <random>
+#include "pFactory.h"
+
+// In this example, each thread evolves a state that depends on the data it receives from the others (as a solver
+// whose search depends on the imported clauses). The threads are slowed down at random, so each run has its own timing.
+// With a Communicator, the received data (and the final states) depend on this timing. With a DeterministicCommunicator,
+// the data are received at the ends of rounds of 100 steps: all runs give the same final states.
+
+static const unsigned int nbSteps = 20000;
+static const unsigned int unitsPerRound = 100;
+
+inline uint64_t mix(uint64_t state, uint64_t value){
+    state ^= value + 0x9E3779B97F4A7C15ULL + (state << 6) + (state >> 2);
+    return state * 0xBF58476D1CE4E5B9ULL;
+}
+
+// A random delay, different at each run
+inline void jitter(std::mt19937& generator){
+    if (generator() % 16 == 0) std::this_thread::yield();
+}
+
+template <class C>
+uint64_t run(unsigned int nbThreads, bool deterministic, double& seconds, uint64_t& nbWaits){
+    pFactory::Group group(nbThreads);
+    C communicator(group, unitsPerRound);
+    std::vector<uint64_t> states(nbThreads);
+    std::random_device device;
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            const unsigned int threadId = group.getThreadId();
+            std::mt19937 generator(device());
+            std::vector<uint64_t> data;
+            uint64_t state = threadId;
+            for (unsigned int step = 0; step < nbSteps; step++){
+                state = mix(state, step);
+                if (state % 8 == 0) communicator.send(state);
+                jitter(generator);
+                if (deterministic && !communicator.work()) continue; // Receive only at the ends of rounds
+                data.clear();
+                communicator.recvAll(data);
+                for (uint64_t value : data) state = mix(state, value);
+            }
+            states[threadId] = state;
+            return 0;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    group.start();
+    group.wait();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    nbWaits = communicator.getNbWaits();
+    uint64_t digest = 0;
+    for (uint64_t state : states) digest = mix(digest, state);
+    return digest;
+}
+
+// To build a Communicator as a DeterministicCommunicator
+template <class T>
+class TimedCommunicator : public pFactory::Communicator<T>
+{
+public:
+    TimedCommunicator(pFactory::Group& g, unsigned int) : pFactory::Communicator<T>(g) {}
+    inline bool work() {return true;}
+    inline uint64_t getNbWaits() const {return 0;}
+};
+
+int main() {
+    const unsigned int nbThreads = std::max(4u, pFactory::getNbCores());
+    bool reproducible = true;
+    uint64_t first = 0;
+    for (unsigned int i = 0; i < 3; i++){
+        double seconds = 0;
+        uint64_t nbWaits = 0;
+        uint64_t digest = run<pFactory::DeterministicCommunicator<uint64_t>>(nbThreads, true, seconds, nbWaits);
+        if (i == 0) first = digest;
+        if (digest != first) reproducible = false;
+        std::cout << "DeterministicCommunicator - run " << i << ": digest " << std::hex << digest << std::dec
+            << " - " << seconds << "s - ends of round that waited: " << nbWaits << "/" << nbThreads * (nbSteps / unitsPerRound) << std::endl;
+    }
+    for (unsigned int i = 0; i < 3; i++){
+        double seconds = 0;
+        uint64_t nbWaits = 0;
+        uint64_t digest = run<TimedCommunicator<uint64_t>>(nbThreads, false, seconds, nbWaits);
+        std::cout << "Communicator - run " << i << ": digest " << std::hex << digest << std::dec << " - " << seconds << "s" << std::endl;
+    }
+    std::cout << "DeterministicCommunicator reproducible: " << (reproducible ? "yes" : "no") << std::endl;
+    return reproducible ? 0 : 1;
+}
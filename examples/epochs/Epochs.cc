@@ -0,0 +1,81 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "pFactory.h"
+
+// In this example, an incremental loop runs many short rounds with the same group and the same communicator.
+// Between two rounds, the group is reloaded and the communicator is reset: its queues and its lists of pointers are
+// reused instead of being reallocated. Each thread selects its good data of a round (the multiples of 10, e.g. the
+// lemmas of small LBD): they are carried over into the next round, the others are forgotten.
+// One round out of ten ends with waitAndKill() and a large timeout (its tasks end long before): the next reload()
+// must neither wait for this timeout nor be stopped by it.
+
+static const unsigned int nbRounds = 100;
+static const unsigned int nbData = 5;
+
+int main() {
+    const unsigned int nbThreads = std::max(4u, pFactory::getNbCores());
+    pFactory::Group group(nbThreads);
+    pFactory::Communicator<int> communicator(group);
+    std::vector<unsigned int> nbReceived(nbThreads, 0), nbCarried(nbThreads, 0);
+    std::vector<std::vector<int>> carried(nbThreads);
+    std::atomic<unsigned int> nbErrors(0);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned int round = 0; round < nbRounds; round++){
+        if (round > 0){
+            group.reload();
+            communicator.reset(carried);
+        }
+        for (unsigned int i = 0; i < nbThreads; i++) {
+            group.add([&, round]() {
+                const unsigned int threadId = group.getThreadId();
+                group.barrier.wait();
+                carried[threadId].clear();
+                for (unsigned int j = 0; j < nbData; j++){
+                    const int data = (int)(round * 1000 + threadId * 10 + j);
+                    communicator.send(data);
+                    if (data % 10 == 0) carried[threadId].push_back(data);
+                }
+                group.barrier.wait();
+                std::vector<int> data;
+                communicator.recvAll(data);
+                nbReceived[threadId] = 0;
+                nbCarried[threadId] = 0;
+                for (int d : data){
+                    if ((unsigned int)d / 1000 == round) nbReceived[threadId]++;
+                    else if ((unsigned int)d / 1000 == round - 1 && d % 10 == 0) nbCarried[threadId]++;
+                    else nbErrors++; // A data of an old round not carried over
+                }
+                return 0;
+            });
+        }
+        group.start();
+        if (round % 10 == 9) group.waitAndKill(3600);
+        else group.wait();
+        if (group.isStopped()) nbErrors++; // Stopped by the timeout of a previous waitAndKill()
+        // Each thread receives the data of the others in this round, and their good data of the previous round
+        for (unsigned int i = 0; i < nbThreads; i++)
+            if (nbReceived[i] != (nbThreads - 1) * nbData || nbCarried[i] != (round ? nbThreads - 1 : 0)) nbErrors++;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "rounds: " << nbRounds << " - threads: " << nbThreads << " - time per round: " << seconds / nbRounds * 1e6 << " us" << std::endl;
+    std::cout << "last round - data received by the thread 0: " << nbReceived[0] << " (carried over: " << nbCarried[0] << ")" << std::endl;
+    std::cout << "errors: " << nbErrors << std::endl;
+    return nbErrors ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include "pFactory.h"
+
+// In this example, threads share unit literals (one int per data) as fast as they can.
+// A Communicator<int> keeps the data of each sender contiguous and a recvAll() copies them with a memcpy per queue.
+// A Literal has a copy constructor, so it is not trivially copyable: the data are kept in a std::deque and copied
+// one by one (the generic path). Both runs check that each thread has received all the literals of the others.
+
+static const unsigned int nbSteps = 2000;
+static const unsigned int nbLiteralsPerStep = 64;
+
+struct Literal
+{
+    int value;
+    Literal(int pvalue = 0) : value(pvalue) {}
+    Literal(const Literal& literal) : value(literal.value) {}
+    Literal& operator=(const Literal& literal) {value = literal.value; return *this;}
+};
+
+inline int64_t valueOf(int literal){return literal;}
+inline int64_t valueOf(const Literal& literal){return literal.value;}
+
+template <class T>
+double share(unsigned int nbThreads, bool& complete){
+    pFactory::Group group(nbThreads);
+    pFactory::Communicator<T> communicator(group);
+    std::vector<uint64_t> nbReceived(nbThreads, 0);
+    std::vector<int64_t> sums(nbThreads, 0);
+
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            const unsigned int threadId = group.getThreadId();
+            std::vector<T> data;
+            auto receive = [&](){
+                data.clear();
+                communicator.recvAll(data);
+                nbReceived[threadId] += data.size();
+                for (const T& literal : data) sums[threadId] += valueOf(literal);
+            };
+            for (unsigned int step = 0; step < nbSteps; step++){
+                for (unsigned int j = 0; j < nbLiteralsPerStep; j++) communicator.send(T((int)(j + 1)));
+                receive();
+            }
+            group.barrier.wait(); // All literals are sent
+            receive();
+            return 0;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    group.start();
+    group.wait();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const uint64_t expected = (uint64_t)(nbThreads - 1) * nbSteps * nbLiteralsPerStep;
+    const int64_t expectedSum = (int64_t)(nbThreads - 1) * nbSteps * (nbLiteralsPerStep * (nbLiteralsPerStep + 1) / 2);
+    complete = true;
+    for (unsigned int i = 0; i < nbThreads; i++)
+        if (nbReceived[i] != expected || sums[i] != expectedSum) complete = false;
+    return (double)expected * nbThreads / seconds;
+}
+
+int main() {
+    const unsigned int nbThreads = std::max(4u, pFactory::getNbCores());
+    bool completeContiguous = false, completeGeneric = false;
+    const double rateGeneric = share<Literal>(nbThreads, completeGeneric);
+    const double rateContiguous = share<int>(nbThreads, completeContiguous);
+    std::cout << "threads: " << nbThreads << std::endl;
+    std::cout << "generic path (std::deque, one copy per data): " << rateGeneric / 1e6 << " M literals received/s" << std::endl;
+    std::cout << "contiguous path (memcpy per queue):           " << rateContiguous / 1e6 << " M literals received/s" << std::endl;
+    std::cout << "speedup: " << rateContiguous / rateGeneric << std::endl;
+    return completeContiguous && completeGeneric ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "pFactory.h"
+
+// In this example, the 9 threads of a group are spread on 3 NUMA nodes with setNumaNodes() (whatever the machine).
+// Each thread sends its data with a HierarchicalCommunicator: the threads of a node receive them directly, the
+// threads of the other nodes receive them through the representatives (the first thread of each node).
+// The example checks that every thread receives every data of the others exactly once.
+
+static const unsigned int nbThreads = 9;
+static const unsigned int nbNodes = 3;
+static const unsigned int nbData = 1000; // Per thread
+
+int main() {
+    pFactory::Group group(nbThreads);
+    std::vector<unsigned int> numaNodes(nbThreads);
+    for (unsigned int i = 0; i < nbThreads; i++) numaNodes[i] = i * nbNodes / nbThreads;
+    group.setNumaNodes(numaNodes);
+    pFactory::HierarchicalCommunicator<unsigned int> communicator(group);
+    std::vector<std::vector<unsigned int>> nbReceived(nbThreads, std::vector<unsigned int>(nbThreads * nbData, 0));
+
+    for (unsigned int i = 0; i < nbThreads; i++){
+        group.add([&]() {
+            const unsigned int threadId = group.getThreadId();
+            std::vector<unsigned int> &received = nbReceived[threadId];
+            std::vector<unsigned int> data;
+            std::size_t nbTotal = 0;
+            auto receive = [&](){
+                data.clear();
+                communicator.recvAll(data);
+                for (unsigned int value : data) received[value]++;
+                nbTotal += data.size();
+            };
+            for (unsigned int k = 0; k < nbData; k++){
+                communicator.send(threadId * nbData + k);
+                if (k % 100 == 0) receive();
+            }
+            // The representatives forward their last data and redistribute the others in recvAll(): all threads
+            // receive (at least once after their last send) until they have all data
+            do{
+                receive();
+                std::this_thread::yield();
+            }while (nbTotal < (nbThreads - 1) * nbData);
+            group.barrier.wait();
+            receive(); // A data received twice would be there
+            return 0;
+        });
+    }
+    group.start();
+    group.wait();
+
+    bool exactlyOnce = true;
+    for (unsigned int i = 0; i < nbThreads; i++)
+        for (unsigned int value = 0; value < nbThreads * nbData; value++)
+            if (nbReceived[i][value] != (value / nbData == i ? 0u : 1u)) exactlyOnce = false;
+    std::cout << "NUMA nodes: " << group.getNbNumaNodes() << " - representatives:";
+    for (unsigned int i = 0; i < nbThreads; i++) if (communicator.isRepresentative(i)) std::cout << " " << i;
+    std::cout << std::endl << "batches exchanged between the nodes: " << communicator.getNbNodeSend() << std::endl;
+    std::cout << "every data received exactly once by every thread: " << (exactlyOnce ? "yes" : "no") << std::endl;
+    return exactlyOnce ? 0 : 1;
+}
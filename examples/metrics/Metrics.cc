@@ -0,0 +1,63 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <chrono>
+#include "pFactory.h"
+
+// In this example, threads share clauses and the main thread periodically displays the traffic metrics
+// of the communicator (data and bytes received, queue depths, lock waits and send-to-receive latencies).
+
+static const unsigned int nbClauses = 20000;
+
+int main() {
+    const unsigned int nbThreads = std::max(2u, pFactory::getNbCores());
+    pFactory::Group group(nbThreads);
+    pFactory::Communicator<std::vector<int>> communicator(group);
+    // Measure the latency of one clause out of 16, count the bytes of the literals
+    communicator.enableMetrics(16, [](const std::vector<int>& clause){return clause.size() * sizeof(int);});
+    std::atomic<unsigned int> nbFinished(0);
+
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            std::vector<int> clause;
+            std::vector<std::vector<int>> clauses;
+            for (unsigned int j = 0; j < nbClauses; j++){
+                clause.assign(2 + (j + group.getThreadId()) % 20, (int)j);
+                communicator.send(clause);
+                if (j % (100 * (group.getThreadId() + 1)) == 0){  // Slower receivers for the highest ids
+                    clauses.clear();
+                    communicator.recvAll(clauses);
+                }
+            }
+            group.barrier.wait();
+            clauses.clear();
+            communicator.recvAll(clauses);
+            nbFinished++;
+            return 0;
+        });
+    }
+    group.start();
+    while (nbFinished < nbThreads){  // Periodic dump
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pFactory::cout() << communicator.getMetrics();
+    }
+    group.wait();
+    pFactory::CommunicatorMetrics metrics = communicator.getMetrics();
+    std::cout << metrics << "data received: " << metrics.getNbData() << " (expected: " << nbThreads * (nbThreads - 1) * nbClauses << ")"
+        << " - bytes: " << metrics.getNbBytes() << std::endl;
+}
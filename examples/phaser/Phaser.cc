@@ -0,0 +1,98 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include "pFactory.h"
+
+// In this example, 8 threads run 24 tasks (as solvers doing rounds of search and exchange) that do not have the same
+// number of rounds: with a Barrier, a task that ends early (or a thread without task) would block the others.
+// With a Phaser of the group, each task is a party from its start to its end. A task arrives at the end of its round,
+// does some local work and then waits for the others (split-phase). At each phase, the example checks that no task
+// arrives once the phase is ended. Then, the tasks of a second group wait for a task that never arrives: the group
+// is stopped and they leave the phaser.
+
+static const unsigned int nbThreads = 8;
+static const unsigned int nbTasks = 24;
+static const unsigned int maxPhases = 4096;
+
+int main() {
+    bool correct = true;
+
+    pFactory::Group group(nbThreads);
+    pFactory::Phaser phaser(group);
+    std::vector<std::atomic<unsigned int>> arrivals(maxPhases);
+    std::vector<std::atomic<unsigned int>> released(maxPhases); // The arrivals seen when the phase is ended
+    for (unsigned int i = 0; i < maxPhases; i++) arrivals[i] = released[i] = 0;
+    std::atomic<unsigned int> nbRounds(0);
+    std::atomic<bool> failed(false);
+
+    for(unsigned int i = 0; i < nbTasks; i++) {
+        group.add([&, i]() {
+            const unsigned int nbTaskRounds = 5 + (i * 7) % 23;
+            uint64_t local = i;
+            for (unsigned int round = 0; round < nbTaskRounds; round++){
+                for (unsigned int j = 0; j < 1000 * (i % 5 + 1); j++) local = local * 6364136223846793005ULL + j;
+                const int phase = phaser.getPhase(); // Cannot end before the arrival of this task
+                arrivals[phase]++;
+                if (phaser.arrive() != phase) failed = true;
+                nbRounds++;
+                if (round == nbTaskRounds - 1 && i % 3 == 0) return (int)(local & 1); // Arrived and ended without waiting
+                for (unsigned int j = 0; j < 500; j++) local = local * 6364136223846793005ULL + j; // Split-phase work
+                const int next = phaser.awaitAdvance(phase);
+                if (next != phase + 1) failed = true;
+                unsigned int seen = arrivals[phase], previous = released[phase];
+                while (previous < seen && !released[phase].compare_exchange_weak(previous, seen));
+            }
+            return (int)(local & 1);
+        });
+    }
+    group.start();
+    group.wait();
+
+    unsigned int expectedRounds = 0;
+    for (unsigned int i = 0; i < nbTasks; i++) expectedRounds += 5 + (i * 7) % 23;
+    for (unsigned int i = 0; i < maxPhases; i++)
+        if (released[i] != 0 && released[i] != arrivals[i]) correct = false; // An arrival after the end of a phase
+    if (failed || nbRounds != expectedRounds || phaser.getNbParties() != 0) correct = false;
+    std::cout << "phases: " << phaser.getPhase() << " - rounds: " << nbRounds << "/" << expectedRounds
+        << " - parties left: " << phaser.getNbParties() << std::endl;
+
+    // A stopped group: the tasks waiting for a task that never arrives leave the phaser
+    pFactory::Group stopped(4);
+    pFactory::Phaser stoppedPhaser(stopped);
+    std::atomic<unsigned int> nbLeft(0);
+    for(unsigned int i = 0; i < 4; i++) {
+        stopped.add([&, i]() {
+            if (i == 0){
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                stopped.stop();
+                while (nbLeft < 3) std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Never arrives
+                return 0;
+            }
+            if (stoppedPhaser.arriveAndAwaitAdvance() == -1) nbLeft++;
+            return 0;
+        });
+    }
+    stopped.start();
+    stopped.wait();
+    std::cout << "tasks that left a stopped group: " << nbLeft << "/3" << std::endl;
+    if (nbLeft != 3) correct = false;
+
+    std::cout << "phaser: " << (correct ? "correct" : "incorrect") << std::endl;
+    return correct ? 0 : 1;
+}
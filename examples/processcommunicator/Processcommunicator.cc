@@ -0,0 +1,118 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <sys/wait.h>
+#include "pFactory.h"
+
+// In this example, the members of a portfolio are processes that share data with a ProcessCommunicator.
+// The process of rank 1 crashes in the middle of its computation: the others are not blocked, they receive the data
+// it has sent before its death and finish. Two processes share then data through a named segment, and the same sharing
+// loop runs with threads and a Communicator.
+
+static const unsigned int nbProcesses = 4;
+static const unsigned int nbData = 200000;
+static const int last = -1; // Sent by a member at the end of its computation
+
+// The sharing loop of a member: the same code for a Communicator and a ProcessCommunicator
+template <class C>
+static void share(C& communicator, unsigned int rank, std::vector<unsigned int>& nbReceived, unsigned int& nbFinished, bool crash){
+    std::vector<int> data;
+    for (unsigned int i = 0; i < nbData; i++){
+        communicator.send((int)i);
+        if (crash && i == nbData / 2) raise(SIGKILL);
+        if (i % 1024 == 0){
+            data.clear();
+            communicator.recvAll(data);
+            nbReceived[rank] += data.size();
+            nbFinished += std::count(data.begin(), data.end(), last);
+            std::this_thread::yield(); // To interleave the members on a small machine
+        }
+    }
+    communicator.send(last);
+}
+
+int main() {
+    // Processes: the communicator is created before the fork, each child takes its rank
+    pFactory::ProcessCommunicator<int> processCommunicator(nbProcesses, 1 << 16);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned int rank = 0; rank < nbProcesses; rank++){
+        if (fork() != 0) continue;
+        processCommunicator.join(rank);
+        std::vector<unsigned int> nbReceived(nbProcesses, 0);
+        unsigned int nbFinished = 0;
+        share(processCommunicator, rank, nbReceived, nbFinished, rank == 1);
+        // Wait for the end of the other members (the crashed one never ends)
+        std::vector<int> data;
+        while (nbFinished < nbProcesses - 2){
+            data.clear();
+            processCommunicator.recvAll(data);
+            nbReceived[rank] += data.size();
+            nbFinished += std::count(data.begin(), data.end(), last);
+            std::this_thread::yield();
+        }
+        printf("process %u - data received: %u - dropped: %u\n", rank, nbReceived[rank], processCommunicator.getNbDropped());
+        fflush(stdout);
+        _exit(0);
+    }
+    unsigned int nbCrashes = 0;
+    for (unsigned int i = 0; i < nbProcesses; i++){
+        int status;
+        wait(&status);
+        if (!WIFEXITED(status)) nbCrashes++;
+    }
+    const double processSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Named segment: the segment left by a crashed run (its creator never removed it) would be joined with its data
+    const std::string name = "/pfactory-processcommunicator";
+    pFactory::SharedMemory::remove(name);
+    bool named = true;
+    {
+        pFactory::ProcessCommunicator<int> namedCommunicator(name, 2, 0, 1024);
+        if (fork() == 0){
+            pFactory::ProcessCommunicator<int> childCommunicator(name, 2, 1, 1024);
+            for (int i = 0; i < 100; i++) childCommunicator.send(i);
+            _exit(0);
+        }
+        int status;
+        wait(&status);
+        std::vector<int> data;
+        namedCommunicator.recvAll(data);
+        if (data.size() != 100 || namedCommunicator.getNbDropped() != 0) named = false;
+    } // The creator removes the segment: a next run starts with a new one
+
+    // Threads
+    pFactory::Group group(nbProcesses);
+    pFactory::Communicator<int> communicator(group);
+    std::vector<unsigned int> nbReceived(nbProcesses, 0);
+    for (unsigned int i = 0; i < nbProcesses; i++){
+        group.add([&]() {
+            group.barrier.wait();
+            unsigned int nbFinished = 0;
+            share(communicator, group.getThreadId(), nbReceived, nbFinished, false);
+            return 0;
+        });
+    }
+    const std::chrono::steady_clock::time_point threadStart = std::chrono::steady_clock::now();
+    group.start();
+    group.wait();
+    const double threadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - threadStart).count();
+
+    std::cout << "processes: " << processSeconds << " s (crashed: " << nbCrashes << ")" << std::endl;
+    std::cout << "named segment: " << (named ? "correct" : "incorrect") << std::endl;
+    std::cout << "threads: " << threadSeconds << " s" << std::endl;
+    return nbCrashes == 1 && named ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "pFactory.h"
+
+// In this example, the tasks of a portfolio run in 4 worker processes with a memory limit of 512MB each.
+// One task crashes (segmentation fault) and one exceeds the memory limit: both are failed, their workers are
+// replaced and the other tasks go on. Then the group is reloaded and its workers run a concurrent portfolio:
+// the first task that ends stops the others.
+
+int main() {
+    pFactory::ProcessGroup group(4, 512 << 20);
+
+    const unsigned int solve = group.registerFunction([&](const std::string& argument) {
+        const unsigned int seed = std::stoi(argument);
+        unsigned int sum = 0;
+        for (unsigned int i = 0; i < 10000000 && !group.isStopped(); i++) sum += (i * seed) % 7;
+        group.setResult("seed " + argument + " on worker " + std::to_string(group.getWorkerId()) + ": " + std::to_string(sum));
+        return 0;
+    });
+    const unsigned int crash = group.registerFunction([](const std::string&) {
+        raise(SIGSEGV);
+        return 0;
+    });
+    const unsigned int hog = group.registerFunction([](const std::string&) {
+        std::vector<std::vector<char>> memory;
+        while (true) memory.push_back(std::vector<char>(64 << 20, 1)); // std::bad_alloc at the memory limit
+        return 0;
+    });
+    const unsigned int search = group.registerFunction([&](const std::string& argument) {
+        const unsigned int steps = std::stoi(argument);
+        unsigned int i = 0;
+        for (; i < steps && !group.isStopped(); i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return i == steps ? 10 : 20; // 10: the task has ended its search, 20: it has been stopped
+    });
+
+    for (unsigned int i = 0; i < 6; i++) group.add(solve, std::to_string(i + 1));
+    group.add(crash);
+    group.add(hog);
+    group.start();
+    group.wait();
+    for (pFactory::Task& task : group.getTasks()){
+        std::cout << task;
+        if (!group.getResult(task.getId()).empty()) std::cout << " " << group.getResult(task.getId());
+        std::cout << std::endl;
+    }
+    std::cout << "crashes: " << group.getNbCrashes() << std::endl;
+    const unsigned int nbCrashes = group.getNbCrashes();
+
+    group.reload();
+    group.concurrent();
+    group.add(search, "10");
+    group.add(search, "100000");
+    group.add(search, "100000");
+    group.start();
+    const int returnCode = group.wait();
+    for (pFactory::Task& task : group.getTasks()) std::cout << task << std::endl;
+    std::cout << "return code of the winner: " << returnCode << std::endl;
+    return nbCrashes == 2 && returnCode == 10 ? 0 : 1;
+}
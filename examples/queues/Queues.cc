@@ -0,0 +1,170 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include "pFactory.h"
+
+// In this example, producer tasks pass work items to consumer tasks (as a pipeline between solver threads).
+// The throughput of the concurrent queues is compared with a std::deque under a mutex with one producer and one
+// consumer, several producers and one consumer, and several producers and consumers, then with the waits of
+// push() and pop(). Each run checks that all items are received once and that the items of a producer are received
+// in the order of their push.
+
+static const uint64_t nbItems = 1 << 20; // Per producer
+static const std::size_t capacity = 1024;
+
+// A queue under a mutex (pop() waits on a condition variable)
+class MutexQueue
+{
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<uint64_t> queue;
+
+public:
+    inline bool try_push(uint64_t value){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(value);
+        }
+        condition.notify_one();
+        return true;
+    }
+
+    inline void push(uint64_t value){try_push(value);}
+
+    inline void pop(uint64_t& value){
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this]{return !queue.empty();});
+        value = queue.front();
+        queue.pop_front();
+    }
+
+    inline bool try_pop(uint64_t& value){
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.empty()) return false;
+        value = queue.front();
+        queue.pop_front();
+        return true;
+    }
+};
+
+// An item: the producer and the number of the item for this producer
+inline uint64_t item(unsigned int producer, uint64_t number){return ((uint64_t)producer << 40) | number;}
+
+template <class Q>
+double run(Q& queue, unsigned int nbProducers, unsigned int nbConsumers, bool waits, bool& correct){
+    pFactory::Group group(nbProducers + nbConsumers);
+    std::atomic<uint64_t> nbPopped(0);
+    std::atomic<bool> ordered(true);
+    const uint64_t total = nbItems * nbProducers;
+    std::vector<uint64_t> sums(nbConsumers, 0);
+
+    for (unsigned int i = 0; i < nbProducers; i++){
+        group.add([&, i]() {
+            for (uint64_t number = 0; number < nbItems; number++){
+                if (waits) queue.push(item(i, number));
+                else while (!queue.try_push(item(i, number))) std::this_thread::yield();
+            }
+            return 0;
+        });
+    }
+    for (unsigned int i = 0; i < nbConsumers; i++){
+        group.add([&, i]() {
+            std::vector<uint64_t> lasts(nbProducers, 0); // The next item expected from each producer
+            uint64_t value;
+            while (nbPopped.load(std::memory_order_relaxed) < total){
+                if (waits) queue.pop(value); // Only with one consumer: it pops all items
+                else if (!queue.try_pop(value)){
+                    std::this_thread::yield();
+                    continue;
+                }
+                nbPopped.fetch_add(1, std::memory_order_relaxed);
+                const unsigned int producer = (unsigned int)(value >> 40);
+                const uint64_t number = value & ((1ULL << 40) - 1);
+                if (number < lasts[producer]) ordered = false;
+                lasts[producer] = number + 1;
+                sums[i] += number;
+            }
+            return 0;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    group.start();
+    group.wait();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t sum = 0;
+    for (uint64_t s : sums) sum += s;
+    if (!ordered || nbPopped != total || sum != nbProducers * (nbItems * (nbItems - 1) / 2)) correct = false;
+    return (double)total / seconds;
+}
+
+template <class Q>
+void print(const char* name, Q& queue, unsigned int nbProducers, unsigned int nbConsumers, bool waits, bool& correct){
+    const double rate = run(queue, nbProducers, nbConsumers, waits, correct);
+    std::cout << "  " << name << ": " << rate / 1e6 << " M items/s" << std::endl;
+}
+
+int main() {
+    const unsigned int nbThreads = std::max(2u, std::min(8u, pFactory::getNbCores() / 2));
+    bool correct = true;
+    std::cout << "1 producer - 1 consumer:" << std::endl;
+    {
+        MutexQueue mutexQueue;
+        pFactory::BoundedQueue<uint64_t> boundedQueue(capacity);
+        pFactory::MpscQueue<uint64_t> mpscQueue;
+        pFactory::SpscQueue<uint64_t> spscQueue(capacity);
+        print("std::deque and std::mutex", mutexQueue, 1, 1, false, correct);
+        print("BoundedQueue             ", boundedQueue, 1, 1, false, correct);
+        print("MpscQueue                ", mpscQueue, 1, 1, false, correct);
+        print("SpscQueue                ", spscQueue, 1, 1, false, correct);
+    }
+    std::cout << nbThreads << " producers - 1 consumer:" << std::endl;
+    {
+        MutexQueue mutexQueue;
+        pFactory::BoundedQueue<uint64_t> boundedQueue(capacity);
+        pFactory::MpscQueue<uint64_t> mpscQueue;
+        print("std::deque and std::mutex", mutexQueue, nbThreads, 1, false, correct);
+        print("BoundedQueue             ", boundedQueue, nbThreads, 1, false, correct);
+        print("MpscQueue                ", mpscQueue, nbThreads, 1, false, correct);
+    }
+    std::cout << nbThreads << " producers - " << nbThreads << " consumers:" << std::endl;
+    {
+        MutexQueue mutexQueue;
+        pFactory::BoundedQueue<uint64_t> boundedQueue(capacity);
+        print("std::deque and std::mutex", mutexQueue, nbThreads, nbThreads, false, correct);
+        print("BoundedQueue             ", boundedQueue, nbThreads, nbThreads, false, correct);
+    }
+    std::cout << "1 producer - 1 consumer with push() and pop() (waits):" << std::endl;
+    {
+        MutexQueue mutexQueue;
+        pFactory::BoundedQueue<uint64_t> boundedQueue(capacity, true);
+        pFactory::MpscQueue<uint64_t> mpscQueue(true);
+        pFactory::SpscQueue<uint64_t> spscQueue(capacity, true);
+        print("std::deque and std::mutex", mutexQueue, 1, 1, true, correct);
+        print("BoundedQueue             ", boundedQueue, 1, 1, true, correct);
+        print("MpscQueue                ", mpscQueue, 1, 1, true, correct);
+        print("SpscQueue                ", spscQueue, 1, 1, true, correct);
+    }
+    std::cout << "queues: " << (correct ? "correct" : "incorrect") << std::endl;
+    return correct ? 0 : 1;
+}
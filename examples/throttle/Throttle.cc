@@ -0,0 +1,70 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "pFactory.h"
+
+// In this example, the thread 0 is a noisy sender: it sends 10 times more data than the others and its data are useless
+// (e.g. long clauses that never propagate). With an import budget, each recvAll() takes at most 8 data served
+// round-robin across the senders. The receivers report the usefulness of the imported data with feedback() and the
+// export rate of the noisy sender decreases, the other senders keep sending all their data.
+
+static const unsigned int nbSteps = 2000;
+
+int main() {
+    const unsigned int nbThreads = std::max(4u, pFactory::getNbCores());
+    pFactory::Group group(nbThreads);
+    pFactory::Communicator<int> communicator(group);
+    communicator.setImportBudget(8);
+    communicator.setExportControl(0.5);
+    std::vector<std::vector<unsigned int>> received(nbThreads, std::vector<unsigned int>(nbThreads, 0));
+
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            const unsigned int threadId = group.getThreadId();
+            std::vector<int> data;
+            std::vector<unsigned int> origins;
+            group.barrier.wait();
+            for (unsigned int step = 0; step < nbSteps; step++){
+                for (unsigned int j = 0; j < (threadId == 0 ? 10u : 1u); j++)
+                    communicator.send(threadId == 0 ? -1 : (int)step); // Negative data are useless
+                data.clear();
+                origins.clear();
+                communicator.recvAll(data, origins);
+                std::vector<unsigned int> nbImported(nbThreads, 0), nbUseful(nbThreads, 0);
+                for (unsigned int k = 0; k < data.size(); k++){
+                    nbImported[origins[k]]++;
+                    if (data[k] >= 0) nbUseful[origins[k]]++;
+                    received[threadId][origins[k]]++;
+                }
+                for (unsigned int sender = 0; sender < nbThreads; sender++)
+                    if (nbImported[sender]) communicator.feedback(sender, nbImported[sender], nbUseful[sender]);
+                std::this_thread::yield(); // To interleave the threads on a small machine
+            }
+            return 0;
+        });
+    }
+    group.start();
+    group.wait();
+
+    for (unsigned int sender = 0; sender < nbThreads; sender++){
+        unsigned int nb = 0;
+        for (unsigned int receiver = 0; receiver < nbThreads; receiver++) nb += received[receiver][sender];
+        std::cout << "sender " << sender << (sender == 0 ? " (noisy)" : "        ") << " - export rate: " << communicator.getExportRate(sender)
+            << " - data received by the others: " << nb << std::endl;
+    }
+    std::cout << "data throttled: " << communicator.getNbThrottled() << std::endl;
+}
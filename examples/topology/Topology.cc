@@ -0,0 +1,62 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "pFactory.h"
+
+// In this example, each thread shares an integer only with its neighbors in a ring:
+// a recvAll() only reads the queues of the neighbors (its cost is O(degree) instead of O(number of threads)).
+// Next, with a hub topology, the thread 0 forwards the integers of all threads to the others.
+
+void communication(pFactory::Group& group, pFactory::Communicator<int>& communicator){
+    communicator.send(group.getThreadId());
+    group.barrier.wait();
+
+    std::vector<int> data;
+    std::stringstream msg;
+    communicator.recvAll(data);
+    // With a hub topology, the others receive the forwarded integers once the hub has called recvAll()
+    group.barrier.wait();
+    communicator.recvAll(data);
+    msg << "Thread " << group.getThreadId() << " receives: ";
+    for(unsigned int j = 0; j < data.size(); ++j)
+        msg  << data[j] << ' ';
+    pFactory::cout() << msg.str() << std::endl;
+}
+
+int main() {
+    unsigned int nbThreads = 8; 
+    pFactory::Group group(nbThreads);
+    
+    pFactory::Communicator<int> ringCommunicator(group, pFactory::Topology::ring(nbThreads));
+    pFactory::Communicator<int> hubCommunicator(group, pFactory::Topology::hub(nbThreads, 0));
+    
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            if (group.getThreadId() == 0)
+                std::cout << "Ring:" << std::endl; 
+            communication(group, ringCommunicator);
+            group.barrier.wait();
+            if (group.getThreadId() == 0)
+                std::cout << "Hub (thread 0):" << std::endl;
+            communication(group, hubCommunicator);
+            return 0;
+        });
+    }
+    group.start();
+    group.wait();
+}
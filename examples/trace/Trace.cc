@@ -0,0 +1,87 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "pFactory.h"
+
+// In this example, the sharing of clauses of a computation is recorded in a trace file. The trace is then replayed
+// at full speed through several communicators: they are compared on the same workload.
+
+static const unsigned int nbSteps = 2000;
+
+int main() {
+    const unsigned int nbThreads = std::max(4u, pFactory::getNbCores());
+    const std::string path = "trace.bin";
+
+    // Record
+    {
+        pFactory::Group group(nbThreads);
+        pFactory::Communicator<std::vector<int>> communicator(group);
+        pFactory::TraceRecorder recorder(path, nbThreads);
+        communicator.record(recorder);
+        for (unsigned int i = 0; i < nbThreads; i++) {
+            group.add([&]() {
+                const unsigned int threadId = group.getThreadId();
+                std::vector<std::vector<int>> clauses;
+                group.barrier.wait();
+                for (unsigned int step = 0; step < nbSteps; step++){
+                    // Some clauses are learnt by all threads
+                    const int literal = (step % 3 == 0) ? (int)step : (int)(step * nbThreads + threadId);
+                    communicator.send(std::vector<int>{literal, -literal - 1, literal + 2});
+                    if (step % 10 == 0){
+                        clauses.clear();
+                        communicator.recvAll(clauses);
+                    }
+                }
+                return 0;
+            });
+        }
+        group.start();
+        group.wait();
+        std::cout << "recorded events: " << recorder.getNbEvents() << " (lost: " << recorder.getNbLost() << ")" << std::endl;
+    }
+
+    // Read
+    pFactory::TraceReader trace(path);
+    std::vector<unsigned int> nbEvents(4, 0);
+    uint64_t nbReceived = 0;
+    for (const pFactory::TraceEvent& event : trace.getEvents()){
+        nbEvents[(unsigned int)event.type]++;
+        if (event.type == pFactory::TraceEventType::advance) nbReceived += event.count;
+    }
+    std::cout << "trace: " << nbEvents[0] << " sends, " << nbEvents[1] << " recvAll, " << nbEvents[3]
+        << " advances (" << nbReceived << " positions), duration: " << trace.getEvents().back().timestamp / 1e6 << " ms" << std::endl;
+
+    // Replay
+    {
+        pFactory::Group group(nbThreads);
+        pFactory::Communicator<std::vector<int>> communicator(group);
+        pFactory::ReplayStatistics statistics = pFactory::replay<std::vector<int>>(trace, group, communicator);
+        std::cout << "Communicator: " << statistics.seconds * 1e3 << " ms - sends: " << statistics.nbSend << " - received: " << statistics.nbReceived << std::endl;
+    }
+    {
+        pFactory::Group group(nbThreads);
+        pFactory::UniqueCommunicator<std::vector<int>> communicator(group, [](const std::vector<int>& clause) {
+            uint64_t hash = 0;
+            for (int literal : clause) hash = hash * 0x9E3779B97F4A7C15ULL + (uint64_t)literal;
+            return hash;
+        });
+        pFactory::ReplayStatistics statistics = pFactory::replay<std::vector<int>>(trace, group, communicator);
+        std::cout << "UniqueCommunicator: " << statistics.seconds * 1e3 << " ms - sends: " << statistics.nbSend << " - received: " << statistics.nbReceived << std::endl;
+    }
+    remove(path.c_str());
+    return nbEvents[0] == nbThreads * nbSteps ? 0 : 1;
+}
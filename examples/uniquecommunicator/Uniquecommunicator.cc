@@ -0,0 +1,64 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "pFactory.h"
+
+// In this example, threads share clauses (std::vector<int>) and several threads learn the same clauses.
+// The UniqueCommunicator drops the duplicates: each distinct clause is received only once.
+// Clauses are normalized (sorted) before being hashed, so {2,-1} and {-1,2} are the same clause.
+
+int main() {
+    unsigned int nbThreads = 4;
+    pFactory::Group group(nbThreads);
+
+    pFactory::UniqueCommunicator<std::vector<int>> clauseCommunicator(group,
+        // Hash of a normalized clause
+        [](const std::vector<int>& clause) {
+            uint64_t hash = 0;
+            for (int literal : clause) hash = hash * 0x100000001B3ULL ^ (uint64_t)(int64_t)literal;
+            return hash;
+        },
+        // Normalization of a clause
+        [](std::vector<int>& clause) {std::sort(clause.begin(), clause.end());});
+
+    for(unsigned int i = 0; i < nbThreads; i++) {
+        group.add([&]() {
+            // All threads learn the clause {threadId, -100} and the clause {1, 2, 3} (in different orders) 
+            int threadId = (int)group.getThreadId();
+            clauseCommunicator.send({threadId + 1, -100});
+            if (threadId % 2) clauseCommunicator.send({3, 2, 1});
+            else clauseCommunicator.send({1, 2, 3});
+            group.barrier.wait();
+
+            std::vector<std::vector<int>> clauses;
+            std::stringstream msg;
+            clauseCommunicator.recvAll(clauses);
+            msg << "Thread " << threadId << " receives:";
+            for (auto& clause : clauses){
+                msg << " {";
+                for (int literal : clause) msg << ' ' << literal;
+                msg << " }";
+            }
+            pFactory::cout() << msg.str() << std::endl;
+            return 0;
+        });
+    }
+    group.start();
+    group.wait();
+    std::cout << "Duplicates dropped: " << clauseCommunicator.getNbDuplicates() << std::endl;
+}
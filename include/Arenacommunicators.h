@@ -0,0 +1,402 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef arenacommunicators_H
+#define arenacommunicators_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "Groups.h"
+#include "Codecs.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace pFactory
+{
+
+/*
+ * A segment of an arena: a contiguous, cache-line aligned block of records.
+ * A record is a header (its number of elements and of bytes) followed by its encoded elements, padded to 8 bytes.
+ */
+struct ArenaSegment
+{
+    std::atomic<std::size_t> used;      /* Bytes published by the sender (final once next is set) */
+    std::atomic<ArenaSegment*> next;    /* The following segment of the sender */
+    uint64_t sequence;                  /* Rank of the segment in the queue of the sender */
+    std::size_t capacity;
+    bool mapped;                        /* Allocated with mmap (huge pages) */
+    char* data;
+};
+
+/*
+ * A communicator for variable-length sequences of a trivially copyable type (e.g. clauses as sequences of int).
+ * Each sender appends length-prefixed records to its own list of segments: sending is a memcpy (segments are
+ * recycled once all receivers have read them), receiving is a linear walk of the memory of the other senders.
+ * The sender does not take any lock, the receivers read in place the records published by the senders.
+ * As the Communicator, each thread receives the data of all other threads.
+ * An optional codec (see Codecs.h) encodes the sequences once on send and decodes them on receive.
+ */
+template <class T, class Codec = RawCodec<T>>
+class ArenaCommunicator
+{
+    static_assert(std::is_trivially_copyable<T>::value, "ArenaCommunicator needs a trivially copyable type");
+    static_assert(alignof(T) <= sizeof(uint64_t), "ArenaCommunicator needs a type aligned on at most 8 bytes");
+
+public:
+    /* \param g The group of threads
+       \param psegmentSize The size in bytes of a segment (a larger record gets its own segment)
+       \param phugePages Allocate the segments with huge pages (Linux only, the size is rounded up to 2MB)
+       \param pcodec The encoding of the sequences
+    */
+    ArenaCommunicator(Group& g, std::size_t psegmentSize = 1 << 20, bool phugePages = false, const Codec& pcodec = Codec());
+    ~ArenaCommunicator();
+
+    /* Send a sequence of size elements
+     */
+    inline void send(const T* data, std::size_t size);
+    inline void send(const std::vector<T>& data){send(data.data(), data.size());}
+
+    /* Receive all sequences in place: visitor(const T* data, std::size_t size) is called for each of them
+       Warning: data is valid only during the call of visitor
+       Remark: with a codec that is not in place, data is decoded in a buffer of the receiver
+       \return The number of sequences received
+    */
+    template <class Visitor>
+    inline std::size_t recvAll(Visitor visitor);
+
+    /* Receive all sequences, their elements are copied one after the other in data
+       \param sizes The size of each sequence received
+    */
+    inline std::size_t recvAll(std::vector<T>& data, std::vector<std::size_t>& sizes)
+    {
+        return recvAll([&](const T* sequence, std::size_t size){
+            std::size_t position = data.size();
+            data.resize(position + size);
+            if (size) memcpy(&data[position], sequence, size * sizeof(T));
+            sizes.push_back(size);
+        });
+    }
+
+    /* Receive all sequences, one vector per sequence (as Communicator<std::vector<T>>)
+    */
+    inline std::size_t recvAll(std::vector<std::vector<T>>& data)
+    {
+        return recvAll([&](const T* sequence, std::size_t size){data.emplace_back(sequence, sequence + size);});
+    }
+
+    /* Say if there are sequences to recuperate
+    */
+    inline bool isEmpty();
+
+    inline uint64_t getNbSend() const;
+    inline uint64_t getNbRecv() const;
+
+    /* The number of segments allocated (the others are recycled)
+    */
+    inline uint64_t getNbAllocations() const;
+
+    /* The number of bytes of the sequences sent before and after their encoding
+    */
+    inline uint64_t getNbRawBytes() const;
+    inline uint64_t getNbEncodedBytes() const;
+
+private:
+    static const std::size_t headerSize = sizeof(uint64_t);
+
+    /* Where a receiver is in the queue of a sender
+    */
+    struct Cursor
+    {
+        ArenaSegment* segment;
+        std::size_t offset;
+    };
+
+    /* The queue of a sender, aligned on a cache line to avoid false sharing between senders
+    */
+    struct alignas(64) Queue
+    {
+        ArenaSegment* head;                           /* The oldest segment (owned by the sender) */
+        ArenaSegment* tail;                           /* The segment in which the sender writes */
+        std::vector<ArenaSegment*> freeSegments;      /* Segments read by all receivers, ready to be reused */
+        std::atomic<uint64_t>* readerSequences;       /* For each receiver, the sequence of the segment it reads */
+        std::atomic<uint64_t> nbSend;
+        std::atomic<uint64_t> nbAllocations;
+        std::atomic<uint64_t> nbRawBytes;
+        std::atomic<uint64_t> nbEncodedBytes;
+    };
+
+    Group& group;
+    const unsigned int nbThreads;
+    const std::size_t segmentSize;
+    const bool hugePages;
+    const Codec codec;
+    std::vector<Queue> queues;
+    std::vector<std::vector<Cursor>> cursors;        /* cursors[receiver][sender], only used by the receiver */
+    std::vector<std::atomic<uint64_t>> nbRecv;
+    std::vector<std::vector<T>> decoded;             /* For each receiver, the last sequence decoded */
+
+    static inline std::size_t recordSize(std::size_t bytes)
+    {
+        return (headerSize + bytes + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+    }
+
+    inline ArenaSegment* allocateSegment(Queue& queue, std::size_t capacity);
+    inline void freeSegment(ArenaSegment* segment);
+    inline ArenaSegment* newSegment(Queue& queue, std::size_t bytes);
+};
+
+template <class T, class Codec>
+ArenaCommunicator<T, Codec>::ArenaCommunicator(Group& g, std::size_t psegmentSize, bool phugePages, const Codec& pcodec)
+    : group(g),
+      nbThreads(g.getNbThreads()),
+      segmentSize(phugePages ? ((psegmentSize + (1 << 21) - 1) & ~((std::size_t)(1 << 21) - 1)) : psegmentSize),
+      hugePages(phugePages),
+      codec(pcodec),
+      queues(nbThreads),
+      cursors(nbThreads, std::vector<Cursor>(nbThreads)),
+      nbRecv(nbThreads),
+      decoded(nbThreads)
+{
+    for (unsigned int i = 0; i < nbThreads; i++){
+        Queue& queue = queues[i];
+        queue.nbSend = 0;
+        queue.nbAllocations = 0;
+        queue.nbRawBytes = 0;
+        queue.nbEncodedBytes = 0;
+        queue.readerSequences = new std::atomic<uint64_t>[nbThreads];
+        for (unsigned int j = 0; j < nbThreads; j++) queue.readerSequences[j] = 0;
+        queue.head = queue.tail = allocateSegment(queue, segmentSize);
+        queue.tail->sequence = 0;
+        for (unsigned int j = 0; j < nbThreads; j++) cursors[j][i] = Cursor{queue.head, 0};
+        nbRecv[i] = 0;
+    }
+}
+
+template <class T, class Codec>
+ArenaCommunicator<T, Codec>::~ArenaCommunicator()
+{
+    for (Queue& queue : queues){
+        for (ArenaSegment* segment = queue.head; segment != NULL;){
+            ArenaSegment* next = segment->next.load();
+            freeSegment(segment);
+            segment = next;
+        }
+        for (ArenaSegment* segment : queue.freeSegments) freeSegment(segment);
+        delete[] queue.readerSequences;
+    }
+}
+
+template <class T, class Codec>
+inline ArenaSegment* ArenaCommunicator<T, Codec>::allocateSegment(Queue& queue, std::size_t capacity)
+{
+    ArenaSegment* segment = new ArenaSegment();
+    segment->used = 0;
+    segment->next = NULL;
+    segment->capacity = capacity;
+    segment->mapped = false;
+    segment->data = NULL;
+#ifdef __linux__
+    if (hugePages && capacity == segmentSize){
+        void* memory = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory != MAP_FAILED){
+            madvise(memory, capacity, MADV_HUGEPAGE);
+            segment->data = (char*)memory;
+            segment->mapped = true;
+        }
+    }
+#endif
+    if (segment->data == NULL){
+        void* memory = NULL;
+        if (posix_memalign(&memory, 64, capacity) != 0) throw std::bad_alloc();
+        segment->data = (char*)memory;
+    }
+    queue.nbAllocations.fetch_add(1, std::memory_order_relaxed);
+    return segment;
+}
+
+template <class T, class Codec>
+inline void ArenaCommunicator<T, Codec>::freeSegment(ArenaSegment* segment)
+{
+#ifdef __linux__
+    if (segment->mapped) munmap(segment->data, segment->capacity);
+    else
+#endif
+    free(segment->data);
+    delete segment;
+}
+
+/* A segment for at least bytes: recycle the segments read by all receivers, allocate only if there is none
+   (called only by the sender)
+*/
+template <class T, class Codec>
+inline ArenaSegment* ArenaCommunicator<T, Codec>::newSegment(Queue& queue, std::size_t bytes)
+{
+    const unsigned int threadId = &queue - &queues[0];
+    uint64_t minSequence = queue.tail->sequence;
+    for (unsigned int j = 0; j < nbThreads; j++){
+        if (j == threadId) continue;
+        uint64_t sequence = queue.readerSequences[j].load(std::memory_order_acquire);
+        if (sequence < minSequence) minSequence = sequence;
+    }
+    while (queue.head->sequence < minSequence){
+        ArenaSegment* segment = queue.head;
+        queue.head = segment->next.load(std::memory_order_relaxed);
+        if (segment->capacity == segmentSize) queue.freeSegments.push_back(segment);
+        else freeSegment(segment); //Only the segments of large records are not recycled
+    }
+
+    ArenaSegment* segment;
+    if (bytes <= segmentSize && !queue.freeSegments.empty()){
+        segment = queue.freeSegments.back();
+        queue.freeSegments.pop_back();
+        segment->used.store(0, std::memory_order_relaxed);
+        segment->next.store(NULL, std::memory_order_relaxed);
+    }else
+        segment = allocateSegment(queue, bytes <= segmentSize ? segmentSize : bytes);
+    segment->sequence = queue.tail->sequence + 1;
+    return segment;
+}
+
+template <class T, class Codec>
+inline void ArenaCommunicator<T, Codec>::send(const T* data, std::size_t size)
+{
+    assert(size <= UINT32_MAX);
+    Queue& queue = queues[group.getThreadId()];
+    const std::size_t maxBytes = recordSize(codec.maxEncodedSize(size));
+    ArenaSegment* segment = queue.tail;
+    std::size_t used = segment->used.load(std::memory_order_relaxed);
+    if (used + maxBytes > segment->capacity){
+        ArenaSegment* next = newSegment(queue, maxBytes);
+        queue.tail->next.store(next, std::memory_order_release); //Publish the segment: its used is final
+        queue.tail = segment = next;
+        used = 0;
+    }
+    //Encode directly in the segment
+    const std::size_t bytes = codec.encode(data, size, (uint8_t*)segment->data + used + headerSize);
+    assert(bytes <= UINT32_MAX);
+    const uint64_t header = ((uint64_t)bytes << 32) | size;
+    memcpy(segment->data + used, &header, headerSize);
+    segment->used.store(used + recordSize(bytes), std::memory_order_release); //Publish the record
+    queue.nbSend.fetch_add(1, std::memory_order_relaxed);
+    queue.nbRawBytes.fetch_add(size * sizeof(T), std::memory_order_relaxed);
+    queue.nbEncodedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+template <class T, class Codec>
+template <class Visitor>
+inline std::size_t ArenaCommunicator<T, Codec>::recvAll(Visitor visitor)
+{
+    const unsigned int threadId = group.getThreadId();
+    std::size_t nb = 0;
+    for (unsigned int threadIdQueue = 0; threadIdQueue < nbThreads; threadIdQueue++){
+        if (threadIdQueue == threadId) continue;
+        Cursor& cursor = cursors[threadId][threadIdQueue];
+        while (true){
+            //next before used: if there is a next segment, used is final
+            ArenaSegment* next = cursor.segment->next.load(std::memory_order_acquire);
+            const std::size_t used = cursor.segment->used.load(std::memory_order_acquire);
+            const char* data = cursor.segment->data;
+            while (cursor.offset < used){
+                uint64_t header;
+                memcpy(&header, data + cursor.offset, headerSize);
+                const std::size_t size = (std::size_t)(header & UINT32_MAX), bytes = (std::size_t)(header >> 32);
+                const char* record = data + cursor.offset + headerSize;
+                if (Codec::inPlace)
+                    visitor(reinterpret_cast<const T*>(record), size);
+                else{
+                    std::vector<T>& sequence = decoded[threadId];
+                    if (sequence.size() < size) sequence.resize(size);
+                    codec.decode((const uint8_t*)record, bytes, size, sequence.data());
+                    visitor((const T*)sequence.data(), size);
+                }
+                cursor.offset += recordSize(bytes);
+                nb++;
+            }
+            if (next == NULL) break;
+            cursor.segment = next;
+            cursor.offset = 0;
+        }
+        //The sender can recycle the segments before this one
+        queues[threadIdQueue].readerSequences[threadId].store(cursor.segment->sequence, std::memory_order_release);
+    }
+    nbRecv[threadId].fetch_add(nb, std::memory_order_relaxed);
+    return nb;
+}
+
+template <class T, class Codec>
+inline bool ArenaCommunicator<T, Codec>::isEmpty()
+{
+    const unsigned int threadId = group.getThreadId();
+    for (unsigned int threadIdQueue = 0; threadIdQueue < nbThreads; threadIdQueue++){
+        if (threadIdQueue == threadId) continue;
+        const Cursor& cursor = cursors[threadId][threadIdQueue];
+        if (cursor.segment->next.load(std::memory_order_acquire) != NULL) return false;
+        if (cursor.offset < cursor.segment->used.load(std::memory_order_acquire)) return false;
+    }
+    return true;
+}
+
+template <class T, class Codec>
+inline uint64_t ArenaCommunicator<T, Codec>::getNbSend() const
+{
+    uint64_t ret = 0;
+    for (const Queue& queue : queues) ret += queue.nbSend.load(std::memory_order_relaxed) * (nbThreads - 1);
+    return ret;
+}
+
+template <class T, class Codec>
+inline uint64_t ArenaCommunicator<T, Codec>::getNbRecv() const
+{
+    uint64_t ret = 0;
+    for (const std::atomic<uint64_t>& nb : nbRecv) ret += nb.load(std::memory_order_relaxed);
+    return ret;
+}
+
+template <class T, class Codec>
+inline uint64_t ArenaCommunicator<T, Codec>::getNbAllocations() const
+{
+    uint64_t ret = 0;
+    for (const Queue& queue : queues) ret += queue.nbAllocations.load(std::memory_order_relaxed);
+    return ret;
+}
+
+template <class T, class Codec>
+inline uint64_t ArenaCommunicator<T, Codec>::getNbRawBytes() const
+{
+    uint64_t ret = 0;
+    for (const Queue& queue : queues) ret += queue.nbRawBytes.load(std::memory_order_relaxed);
+    return ret;
+}
+
+template <class T, class Codec>
+inline uint64_t ArenaCommunicator<T, Codec>::getNbEncodedBytes() const
+{
+    uint64_t ret = 0;
+    for (const Queue& queue : queues) ret += queue.nbEncodedBytes.load(std::memory_order_relaxed);
+    return ret;
+}
+
+} // namespace pFactory
+
+#endif
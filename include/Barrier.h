@@ -15,48 +15,138 @@
  *   You should have received a copy of the GNU General Public License
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
-#include <condition_variable>
-#include <mutex>  
-
 #ifndef barrier_H
 #define	barrier_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "Eventcounts.h"
+
 namespace pFactory
 {
+  /* A barrier of nbThreads threads (any threads, the same or others at each generation).
+     The threads arrive in a combining tree of counters, each one on its own cache line: a thread takes a seat in a
+     leaf (the leaf of its hash, or the next one with a free seat), the last one to fill a node goes up to its parent
+     and the thread that fills the root is the last arriver. So the threads do not all update the same counter.
+     The other threads spin for a bounded time on the generation, then sleep on a futex until the last arriver wakes
+     them up (no spin when there are more threads than cores).
+     A thread that calls wait() when nbThreads threads have already arrived in the generation (all seats are taken)
+     waits for its end and arrives in the next generation (as with a single counter).
+  */
   class Barrier
   {
   private:
-    std::mutex m;
-    std::condition_variable cv;
+    static const unsigned int arity = 4; /* Number of seats of a node */
+
+    /* A node of the tree: the generation of its last arrival and the number of seats taken during this generation
+    */
+    struct alignas(64) Node
+    {
+      std::atomic<uint64_t> seats;
+      unsigned int nbSeats;
+    };
+
     unsigned int nbThreads;
-    unsigned int tmpNbThreads;
-    unsigned int nbGenerations;
-    
+    unsigned int nbSpins;
+    std::vector<Node> nodes;                /* The levels of the tree one after the other, the root is the last node */
+    std::vector<unsigned int> levels;       /* The index of the first node of each level (and the number of nodes) */
+    std::atomic<uint32_t> generation;
+    EventCount released;                    /* The threads sleeping until the end of the generation */
+
+    /* Take a seat in a node for the generation current
+       \return 0 if the node is full, 1 if a seat is taken, 2 if the last seat is taken
+    */
+    static inline unsigned int takeSeat(Node& node, uint32_t current)
+    {
+      uint64_t seats = node.seats.load(std::memory_order_relaxed);
+      while (true){
+        const uint64_t taken = (seats >> 32) == current ? (seats & 0xFFFFFFFF) : 0;
+        if (taken == node.nbSeats) return 0;
+        if (node.seats.compare_exchange_weak(seats, ((uint64_t)current << 32) | (taken + 1), std::memory_order_acq_rel, std::memory_order_relaxed))
+          return taken + 1 == node.nbSeats ? 2 : 1;
+      }
+    }
+
   public:
-    explicit Barrier(unsigned int p_nbThreads): 
+    /* \param p_nbThreads The number of threads that call wait() at each generation
+       \param p_nbSpins The number of times a thread checks the generation before sleeping (by default, 0 if there are
+       more threads than cores)
+    */
+    explicit Barrier(unsigned int p_nbThreads, int p_nbSpins = -1): 
       nbThreads(p_nbThreads), 
-      tmpNbThreads(p_nbThreads),
-      nbGenerations(0)
-      {}
+      nbSpins(p_nbSpins >= 0 ? p_nbSpins : (p_nbThreads <= std::thread::hardware_concurrency() ? 4096 : 0)),
+      generation(0)
+      {
+        //The tree level by level: each level has one seat per node of the level below
+        std::vector<unsigned int> nbSeats;
+        unsigned int nbArrivals = std::max(p_nbThreads, 1u);
+        while (true){
+          const unsigned int nbNodes = (nbArrivals + arity - 1) / arity;
+          levels.push_back(nbSeats.size());
+          for (unsigned int i = 0; i < nbNodes; i++) nbSeats.push_back(nbArrivals - i * arity < arity ? nbArrivals - i * arity : arity);
+          if (nbNodes == 1) break;
+          nbArrivals = nbNodes;
+        }
+        levels.push_back(nbSeats.size());
+        nodes = std::vector<Node>(nbSeats.size());
+        for (unsigned int i = 0; i < nodes.size(); i++){
+          nodes[i].seats = (uint64_t)UINT32_MAX << 32; //No seat is taken for the generation 0
+          nodes[i].nbSeats = nbSeats[i];
+        }
+      }
 
     ~Barrier(){}
 
     //Return true if the thread is the last thread to call wait 
     bool wait()
     {
-      std::unique_lock<std::mutex> lock{m};
-      unsigned int tmpNbGenerations = nbGenerations;
-      
-      if (--tmpNbThreads==0){
-        nbGenerations++;//This generation is finished
-        tmpNbThreads=nbThreads;//Fix the good number of threads for the next generation
-        cv.notify_all();
+      uint32_t current = generation.load(std::memory_order_acquire);
+      //Take a seat in a leaf, starting with the leaf of this thread
+      thread_local static const std::size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ULL >> 16;
+      const unsigned int nbLeaves = levels[1];
+      unsigned int index = hash % nbLeaves;
+      unsigned int seat;
+      unsigned int nbProbes = 0;
+      while ((seat = takeSeat(nodes[index], current)) == 0){
+        index = (index + 1) % nbLeaves;
+        //All seats are taken: this thread is one too many in this generation, it arrives in the next one
+        if (++nbProbes % nbLeaves == 0){
+          std::this_thread::yield();
+          current = generation.load(std::memory_order_acquire);
+        }
+      }
+      //Go up while this thread fills the nodes
+      for (unsigned int level = 1; seat == 2 && level < levels.size() - 1; level++){
+        index = levels[level] + (index - levels[level - 1]) / arity;
+        seat = takeSeat(nodes[index], current);
+      }
+      if (seat == 2){ //The root is full: this generation is finished
+        generation.store(current + 1, std::memory_order_release);
+        released.notifyAll();
         return true;
       }
-      //Sleep while the generation has not changed
-      cv.wait(lock,[&tmpNbGenerations,this] {return tmpNbGenerations != nbGenerations;});
-      return false;
+      //Spin, then sleep while the generation has not changed
+      for (unsigned int i = 0; i < nbSpins; i++){
+        if (generation.load(std::memory_order_acquire) != current) return false;
+        cpuRelax();
+      }
+      while (true){
+        const uint32_t key = released.prepareWait();
+        if (generation.load(std::memory_order_acquire) != current){
+          released.cancelWait();
+          return false;
+        }
+        released.wait(key, std::chrono::milliseconds(100));
+      }
     }
+
+    inline unsigned int getNbThreads() const {return nbThreads;}
   };
 }
 #endif
-
@@ -0,0 +1,156 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef boundregisters_H
+#define boundregisters_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+namespace pFactory
+{
+
+/*
+ * Storage of a bound: a std::atomic<T> for small types (lock-free and wait-free reads),
+ * a sequence lock for larger structures (readers retry while a writer is publishing).
+ */
+template <class T, bool isSmall = (sizeof(T) <= sizeof(uint64_t))>
+class BoundStorage
+{
+private:
+    std::atomic<T> value;
+
+public:
+    explicit BoundStorage(const T& initial) : value(initial) {}
+
+    inline T load() const {return value.load(std::memory_order_acquire);}
+
+    /* Replace the value while better(candidate, value) is true
+       \return false if the value is at least as good as the candidate
+    */
+    template <class Compare>
+    inline bool improve(const T& candidate, Compare& better){
+        T current = value.load(std::memory_order_relaxed);
+        while (better(candidate, current))
+            if (value.compare_exchange_weak(current, candidate, std::memory_order_release, std::memory_order_relaxed)) return true;
+        return false;
+    }
+};
+
+template <class T>
+class BoundStorage<T, false>
+{
+private:
+    static const unsigned int nbWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence; /* Odd while a writer is publishing */
+    std::atomic<uint64_t> words[nbWords];
+
+    inline void store(const T& candidate){
+        uint64_t buffer[nbWords] = {};
+        memcpy(buffer, &candidate, sizeof(T));
+        for (unsigned int i = 0; i < nbWords; i++) words[i].store(buffer[i], std::memory_order_relaxed);
+    }
+
+public:
+    explicit BoundStorage(const T& initial) : sequence(0) {store(initial);}
+
+    inline T load() const {
+        uint64_t buffer[nbWords];
+        while (true){
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            for (unsigned int i = 0; i < nbWords; i++) buffer[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (!(before & 1) && sequence.load(std::memory_order_relaxed) == before) break;
+        }
+        T ret;
+        memcpy(&ret, buffer, sizeof(T));
+        return ret;
+    }
+
+    template <class Compare>
+    inline bool improve(const T& candidate, Compare& better){
+        while (true){
+            uint64_t before = sequence.load(std::memory_order_relaxed);
+            if (before & 1) continue; //Another writer is publishing
+            if (!better(candidate, load())) return false;
+            if (!sequence.compare_exchange_weak(before, before + 1, std::memory_order_acquire, std::memory_order_relaxed)) continue;
+            std::atomic_thread_fence(std::memory_order_release);
+            store(candidate);
+            sequence.store(before + 2, std::memory_order_release);
+            return true;
+        }
+    }
+};
+
+/*
+ * To share the best bound of an optimization problem between threads (instead of a Communicator of all bounds).
+ * A bound is published only if it improves the current one (Compare(a, b) is true if a is better than b,
+ * std::less<T> for a minimization). T has to be trivially copyable (a scalar or a small structure).
+ * The version counter increases at each improvement: a thread can cheaply check if the bound has changed since its last look.
+ */
+template <class T, class Compare = std::less<T>>
+class BoundRegister
+{
+    static_assert(std::is_trivially_copyable<T>::value, "BoundRegister: T has to be trivially copyable");
+
+private:
+    BoundStorage<T> bound;
+    std::atomic<uint64_t> version;
+    Compare better;
+
+public:
+    /* \param initial The initial bound (e.g. INT_MAX for a minimization)
+       \param compare compare(a, b) is true if the bound a is better than b
+    */
+    explicit BoundRegister(const T& initial, const Compare& compare = Compare()):
+        bound(initial),
+        version(0),
+        better(compare)
+    {}
+
+    /* Publish a bound if it is better than the current one
+       \return true if the bound has been improved
+    */
+    inline bool improve(const T& candidate){
+        if (!bound.improve(candidate, better)) return false;
+        version.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    /* The current best bound */
+    inline T get() const {return bound.load();}
+
+    /* The number of improvements */
+    inline uint64_t getVersion() const {return version.load(std::memory_order_acquire);}
+
+    /* Say if the bound has been improved since the version lastVersion (lastVersion is updated)
+    */
+    inline bool hasChanged(uint64_t &lastVersion) const {
+        uint64_t current = getVersion();
+        if (current == lastVersion) return false;
+        lastVersion = current;
+        return true;
+    }
+};
+
+} // namespace pFactory
+
+#endif
@@ -0,0 +1,278 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef channelcommunicators_H
+#define channelcommunicators_H
+
+#include <tuple>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "Communicators.h"
+
+namespace pFactory
+{
+
+/* The largest size and alignment of several types */
+template <class... Types> struct ChannelLayout;
+template <class Head>
+struct ChannelLayout<Head>
+{
+    static const std::size_t size = sizeof(Head);
+    static const std::size_t align = alignof(Head);
+};
+template <class Head, class... Tail>
+struct ChannelLayout<Head, Tail...>
+{
+    static const std::size_t size = sizeof(Head) > ChannelLayout<Tail...>::size ? sizeof(Head) : ChannelLayout<Tail...>::size;
+    static const std::size_t align = alignof(Head) > ChannelLayout<Tail...>::align ? alignof(Head) : ChannelLayout<Tail...>::align;
+};
+
+/* The operations on the data of the channel given at run time (I is the index of Head) */
+template <unsigned int I, class... Types> struct ChannelOps;
+template <unsigned int I>
+struct ChannelOps<I>
+{
+    static inline void copy(unsigned int, void*, const void*) {}
+    static inline void move(unsigned int, void*, void*) {}
+    static inline void destroy(unsigned int, void*) {}
+    template <class Sinks> static inline void dispatch(unsigned int, void*, Sinks&) {}
+};
+template <unsigned int I, class Head, class... Tail>
+struct ChannelOps<I, Head, Tail...>
+{
+    typedef ChannelOps<I + 1, Tail...> Next;
+
+    static inline void copy(unsigned int channel, void* to, const void* from)
+    {
+        if (channel == I) new (to) Head(*static_cast<const Head*>(from));
+        else Next::copy(channel, to, from);
+    }
+
+    static inline void move(unsigned int channel, void* to, void* from)
+    {
+        if (channel == I) new (to) Head(std::move(*static_cast<Head*>(from)));
+        else Next::move(channel, to, from);
+    }
+
+    static inline void destroy(unsigned int channel, void* data)
+    {
+        if (channel == I) static_cast<Head*>(data)->~Head();
+        else Next::destroy(channel, data);
+    }
+
+    /* Give the data to the sink of its channel: an output vector or a handler */
+    template <class Sinks>
+    static inline void dispatch(unsigned int channel, void* data, Sinks& sinks)
+    {
+        if (channel == I) put(std::get<I>(sinks), *static_cast<Head*>(data));
+        else Next::dispatch(channel, data, sinks);
+    }
+
+    static inline void put(std::vector<Head>& output, Head& data) {output.push_back(std::move(data));}
+    static inline void put(const std::function<void(Head&)>& handler, Head& data) {handler(data);}
+};
+
+/*
+ * A data of one of several channels (a tagged union): the index of its channel and the data itself.
+ */
+template <class... Types>
+class ChannelRecord
+{
+    static_assert(sizeof...(Types) > 0, "A ChannelRecord needs at least one channel");
+    typedef ChannelOps<0, Types...> Ops;
+
+private:
+    unsigned int channel; /* UINT_MAX for an empty record */
+    typename std::aligned_storage<ChannelLayout<Types...>::size, ChannelLayout<Types...>::align>::type storage;
+
+public:
+    template <unsigned int I> using Type = typename std::tuple_element<I, std::tuple<Types...>>::type;
+    template <unsigned int I> struct Index {};
+
+    ChannelRecord() : channel(UINT_MAX) {}
+
+    template <unsigned int I, class U>
+    ChannelRecord(Index<I>, U&& data) : channel(I) {new (&storage) Type<I>(std::forward<U>(data));}
+
+    ChannelRecord(const ChannelRecord& toCopy) : channel(toCopy.channel) {Ops::copy(channel, &storage, &toCopy.storage);}
+
+    ChannelRecord(ChannelRecord&& toMove) : channel(toMove.channel) {Ops::move(channel, &storage, &toMove.storage);}
+
+    ChannelRecord& operator=(const ChannelRecord& toCopy)
+    {
+        if (this == &toCopy) return *this;
+        Ops::destroy(channel, &storage);
+        channel = toCopy.channel;
+        Ops::copy(channel, &storage, &toCopy.storage);
+        return *this;
+    }
+
+    ChannelRecord& operator=(ChannelRecord&& toMove)
+    {
+        if (this == &toMove) return *this;
+        Ops::destroy(channel, &storage);
+        channel = toMove.channel;
+        Ops::move(channel, &storage, &toMove.storage);
+        return *this;
+    }
+
+    ~ChannelRecord() {Ops::destroy(channel, &storage);}
+
+    inline unsigned int getChannel() const {return channel;}
+
+    template <unsigned int I> inline Type<I>& get() {assert(channel == I); return *reinterpret_cast<Type<I>*>(&storage);}
+    template <unsigned int I> inline const Type<I>& get() const {assert(channel == I); return *reinterpret_cast<const Type<I>*>(&storage);}
+
+    /* Move the data to the sink of its channel (sinks is a tuple with one output vector or one handler per channel) */
+    template <class Sinks> inline void dispatch(Sinks& sinks) {Ops::dispatch(channel, &storage, sinks);}
+};
+
+/*
+ * A communicator with several typed channels (e.g. units, binary clauses, long clauses and bounds).
+ * All channels share the queues, the locks and the positions of one Communicator: a recvAll() browses the queues once
+ * for all channels, instead of once per communicator. The data of each channel go in their own output.
+ * The priorities of the channels give the order in which the handlers of a recvAll() are called (e.g. the bounds and
+ * the units before the long clauses).
+ * Remark: the settings of the Communicator (topology, capacity, budgets, metrics, ...) apply to all channels.
+ */
+template <class... Types>
+class ChannelCommunicator : public Communicator<ChannelRecord<Types...>>
+{
+    public:
+        typedef ChannelRecord<Types...> Record;
+        template <unsigned int I> using Type = typename Record::template Type<I>;
+        static const unsigned int nbChannels = sizeof...(Types);
+
+    private:
+        std::vector<unsigned int> order;                    /* The channels by decreasing priority */
+        std::vector<int> priorities;
+        std::vector<std::vector<Record>> buffers;           /* Per thread, the received records (reused by each recvAll()) */
+        std::vector<std::vector<unsigned int>> nbChannelSend; /* Per thread and per channel, written by the thread only */
+        std::vector<std::vector<unsigned int>> nbChannelRecv;
+
+        /* Receive the records of all channels in the buffer of the calling thread */
+        inline std::vector<Record>& recvRecords(unsigned int threadId)
+        {
+            std::vector<Record>& buffer = buffers[threadId];
+            buffer.clear();
+            Communicator<Record>::recvAll(buffer);
+            for (const Record& record : buffer) nbChannelRecv[threadId][record.getChannel()]++;
+            return buffer;
+        }
+
+    public:
+        ChannelCommunicator(Group& g)
+            : Communicator<Record>::Communicator(g),
+            order(nbChannels),
+            priorities(nbChannels, 0),
+            buffers(g.getNbThreads()),
+            nbChannelSend(g.getNbThreads(), std::vector<unsigned int>(nbChannels, 0)),
+            nbChannelRecv(g.getNbThreads(), std::vector<unsigned int>(nbChannels, 0))
+        {
+            for (unsigned int i = 0; i < nbChannels; i++) order[i] = i;
+        }
+
+        ChannelCommunicator(Group& g, const Topology& topology)
+            : Communicator<Record>::Communicator(g, topology),
+            order(nbChannels),
+            priorities(nbChannels, 0),
+            buffers(g.getNbThreads()),
+            nbChannelSend(g.getNbThreads(), std::vector<unsigned int>(nbChannels, 0)),
+            nbChannelRecv(g.getNbThreads(), std::vector<unsigned int>(nbChannels, 0))
+        {
+            for (unsigned int i = 0; i < nbChannels; i++) order[i] = i;
+        }
+
+        /* Set the priority of a channel (0 by default): the channels of higher priority are dispatched first
+          Warning: has to be called before the computation of tasks
+        */
+        inline void setPriority(unsigned int channel, int priority)
+        {
+            priorities[channel] = priority;
+            for (unsigned int i = 0; i < nbChannels; i++) order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b){return priorities[a] > priorities[b];});
+        }
+        inline int getPriority(unsigned int channel) const {return priorities[channel];}
+
+        /* Send a data on the channel I
+          \param data Data to send
+          \return false if the data is not sent (see Communicator::send()), true otherwise
+        */
+        template <unsigned int I>
+        inline bool send(const Type<I>& data)
+        {
+            const unsigned int threadId = this->getThreadId();
+            if (!this->senders[threadId] || this->detached[threadId]) return false; //Without building a record
+            if (!Communicator<Record>::send(Record(typename Record::template Index<I>(), data))) return false;
+            nbChannelSend[threadId][I]++;
+            return true;
+        }
+
+        /* Same as Communicator::trySend() on the channel I
+          \return false if the data is not sent, true otherwise
+        */
+        template <unsigned int I>
+        inline bool trySend(const Type<I>& data)
+        {
+            if (!Communicator<Record>::trySend(Record(typename Record::template Index<I>(), data))) return false;
+            nbChannelSend[this->getThreadId()][I]++;
+            return true;
+        }
+
+        /* Receive the data of all channels with one browse of the queues
+          \param outputs One vector per channel: the received data are added at their end
+        */
+        inline void recvAll(std::vector<Types>&... outputs)
+        {
+            std::tuple<std::vector<Types>&...> sinks(outputs...);
+            for (Record& record : recvRecords(this->getThreadId())) record.dispatch(sinks);
+        }
+
+        /* Receive the data of all channels with one browse of the queues and call the handler of each channel,
+           the channels of higher priority first (the data of a channel are given in their order of reception)
+          \param handlers One handler per channel
+        */
+        inline void recvAll(const std::function<void(Types&)>&... handlers)
+        {
+            std::tuple<const std::function<void(Types&)>&...> sinks(handlers...);
+            std::vector<Record>& buffer = recvRecords(this->getThreadId());
+            for (unsigned int channel : order)
+                for (Record& record : buffer)
+                    if (record.getChannel() == channel) record.dispatch(sinks);
+        }
+
+        /* The number of data sent (not throttled nor dropped) and received on a channel
+        */
+        inline unsigned int getNbChannelSend(unsigned int channel) const
+        {
+            unsigned int ret = 0;
+            for (const std::vector<unsigned int>& nb : nbChannelSend) ret += nb[channel];
+            return ret;
+        }
+
+        inline unsigned int getNbChannelRecv(unsigned int channel) const
+        {
+            unsigned int ret = 0;
+            for (const std::vector<unsigned int>& nb : nbChannelRecv) ret += nb[channel];
+            return ret;
+        }
+};
+
+} // namespace pFactory
+
+#endif
@@ -0,0 +1,247 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef codecs_H
+#define codecs_H
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PFACTORY_AVX2_UNPACK
+#include <immintrin.h>
+#endif
+
+namespace pFactory
+{
+
+/*
+ * The codecs of an ArenaCommunicator: a sequence is encoded once by the sender and decoded by each receiver.
+ * A codec provides:
+ *   - inPlace: true if the encoded sequence is the sequence itself (the receivers read it without copy)
+ *   - maxEncodedSize(size): an upper bound of the number of bytes of an encoded sequence of size elements
+ *   - encode(data, size, out): write the sequence in out, return the number of bytes written
+ *   - decode(in, bytes, size, out): write the size elements of the encoded sequence in out
+ * The methods are const: a codec is shared by all threads.
+ */
+
+/* No encoding: the elements are copied as they are
+*/
+template <class T>
+struct RawCodec
+{
+    static const bool inPlace = true;
+
+    inline std::size_t maxEncodedSize(std::size_t size) const {return size * sizeof(T);}
+
+    inline std::size_t encode(const T* data, std::size_t size, uint8_t* out) const
+    {
+        if (size) memcpy(out, data, size * sizeof(T));
+        return size * sizeof(T);
+    }
+
+    inline void decode(const uint8_t* in, std::size_t, std::size_t size, T* out) const
+    {
+        if (size) memcpy(out, in, size * sizeof(T));
+    }
+};
+
+/* Zigzag encoding of the difference between two consecutive elements (small for sorted sequences, as the literals of a clause)
+*/
+template <class T>
+struct Zigzag
+{
+    static_assert(std::is_integral<T>::value, "The delta codecs need an integral type");
+    typedef typename std::make_unsigned<T>::type Unsigned;
+    typedef typename std::make_signed<T>::type Signed; //The sign of the difference, also for an unsigned T
+
+    static inline Unsigned encode(T current, T previous)
+    {
+        const Signed delta = (Signed)((Unsigned)current - (Unsigned)previous);
+        return ((Unsigned)delta << 1) ^ (Unsigned)(delta >> (sizeof(T) * 8 - 1));
+    }
+
+    static inline T decode(Unsigned value, T previous)
+    {
+        const Unsigned delta = (value >> 1) ^ (Unsigned)(-(Signed)(value & 1));
+        return (T)((Unsigned)previous + delta);
+    }
+};
+
+/* Delta + varint: each difference takes 7 bits per byte (1 byte for a difference in [-64, 63])
+*/
+template <class T>
+struct DeltaVarintCodec
+{
+    static const bool inPlace = false;
+    typedef typename Zigzag<T>::Unsigned Unsigned;
+
+    inline std::size_t maxEncodedSize(std::size_t size) const {return size * ((sizeof(T) * 8 + 6) / 7);}
+
+    inline std::size_t encode(const T* data, std::size_t size, uint8_t* out) const
+    {
+        uint8_t* position = out;
+        T previous = 0;
+        for (std::size_t i = 0; i < size; i++){
+            Unsigned value = Zigzag<T>::encode(data[i], previous);
+            previous = data[i];
+            while (value >= 0x80){
+                *position++ = (uint8_t)(value | 0x80);
+                value >>= 7;
+            }
+            *position++ = (uint8_t)value;
+        }
+        return position - out;
+    }
+
+    inline void decode(const uint8_t* in, std::size_t, std::size_t size, T* out) const
+    {
+        T previous = 0;
+        for (std::size_t i = 0; i < size; i++){
+            Unsigned value = *in++;
+            if (value >= 0x80){ //Rare for sorted sequences: the difference does not fit in one byte
+                value &= 0x7f;
+                unsigned int shift = 7;
+                uint8_t byte;
+                do{
+                    byte = *in++;
+                    value |= (Unsigned)(byte & 0x7f) << shift;
+                    shift += 7;
+                }while (byte >= 0x80);
+            }
+            previous = out[i] = Zigzag<T>::decode(value, previous);
+        }
+    }
+};
+
+#ifdef PFACTORY_AVX2_UNPACK
+/* Say if the processor has AVX2 (checked once) */
+inline bool hasAvx2()
+{
+    static const bool ret = __builtin_cpu_supports("avx2");
+    return ret;
+}
+
+/* Decode nb 32-bit elements of width bits (at most 25, so that an element and its shift fit in 32 bits) by blocks of 8:
+   unpack (a block starts at a byte boundary, so the byte offsets and the shifts of its lanes are constant),
+   undo the zigzag, then add the prefix sum of the block to the last element of the previous block.
+   The packed sequence has to be readable 4 bytes beyond the start of the last element
+   \return The number of elements decoded (a multiple of 8)
+*/
+__attribute__((target("avx2"))) inline std::size_t decodeAvx2(const uint8_t* packed, unsigned int width, std::size_t nb, uint32_t* out)
+{
+    const __m256i bits = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)width));
+    const __m256i offsets = _mm256_srli_epi32(bits, 3);
+    const __m256i shifts = _mm256_and_si256(bits, _mm256_set1_epi32(7));
+    const __m256i mask = _mm256_set1_epi32((int)((1u << width) - 1));
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i previous = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= nb; i += 8, packed += width){
+        const __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(packed), offsets, 1);
+        const __m256i values = _mm256_and_si256(_mm256_srlv_epi32(words, shifts), mask);
+        __m256i deltas = _mm256_xor_si256(_mm256_srli_epi32(values, 1), _mm256_sub_epi32(_mm256_setzero_si256(), _mm256_and_si256(values, one)));
+        //Prefix sum in each half, then the last sum of the low half is added to the high half
+        deltas = _mm256_add_epi32(deltas, _mm256_slli_si256(deltas, 4));
+        deltas = _mm256_add_epi32(deltas, _mm256_slli_si256(deltas, 8));
+        deltas = _mm256_add_epi32(deltas, _mm256_shuffle_epi32(_mm256_permute2x128_si256(deltas, deltas, 0x08), 0xFF));
+        previous = _mm256_add_epi32(deltas, _mm256_permutevar8x32_epi32(previous, _mm256_set1_epi32(7)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), previous);
+    }
+    return i;
+}
+#endif
+
+/* Delta + bit-packing: all differences of a sequence are stored with the same number of bits.
+   The decoding unpacks the differences and sums them by blocks of 8 with AVX2 when the processor has it (32-bit types
+   and widths of at most 25 bits), with scalar loops otherwise or if simd is false.
+   Only for types of at most 32 bits (e.g. the literals of a clause).
+*/
+template <class T, bool simd = true>
+struct DeltaBitPackCodec
+{
+    static_assert(sizeof(T) <= sizeof(uint32_t), "DeltaBitPackCodec needs a type of at most 32 bits");
+    static const bool inPlace = false;
+    typedef typename Zigzag<T>::Unsigned Unsigned;
+
+    /* One byte for the width and the packed bits (the encoder writes by 64-bit words, hence the padding) */
+    inline std::size_t maxEncodedSize(std::size_t size) const {return 1 + size * sizeof(T) + sizeof(uint64_t);}
+
+    inline std::size_t encode(const T* data, std::size_t size, uint8_t* out) const
+    {
+        Unsigned all = 0;
+        T previous = 0;
+        for (std::size_t i = 0; i < size; i++){
+            all |= Zigzag<T>::encode(data[i], previous);
+            previous = data[i];
+        }
+        unsigned int width = 0;
+        while (width < sizeof(T) * 8 && (all >> width) != 0) width++;
+        out[0] = (uint8_t)width;
+
+        const std::size_t bytes = (size * width + 7) / 8;
+        memset(out + 1, 0, bytes + sizeof(uint64_t));
+        previous = 0;
+        for (std::size_t i = 0; i < size; i++){
+            const uint64_t value = Zigzag<T>::encode(data[i], previous);
+            previous = data[i];
+            const std::size_t bit = i * width;
+            uint64_t word;
+            memcpy(&word, out + 1 + bit / 8, sizeof(uint64_t));
+            word |= value << (bit % 8);
+            memcpy(out + 1 + bit / 8, &word, sizeof(uint64_t));
+        }
+        return 1 + bytes;
+    }
+
+    inline void decode(const uint8_t* in, std::size_t bytes, std::size_t size, T* out) const
+    {
+        const unsigned int width = in[0];
+        const uint64_t mask = ((uint64_t)1 << width) - 1;
+        const uint8_t* packed = in + 1;
+        const std::size_t nbPacked = bytes - 1;
+        Unsigned* values = reinterpret_cast<Unsigned*>(out);
+        //The elements that can be read by a 64-bit word without going beyond the sequence
+        std::size_t nbFast = 0;
+        if (width && nbPacked >= sizeof(uint64_t)) nbFast = std::min(size, ((nbPacked - 7) * 8 + width - 1) / width);
+        std::size_t first = 0; //The elements decoded by blocks of 8
+#ifdef PFACTORY_AVX2_UNPACK
+        if (simd && sizeof(Unsigned) == sizeof(uint32_t) && width <= 25 && hasAvx2())
+            first = decodeAvx2(packed, width, nbFast, reinterpret_cast<uint32_t*>(values));
+#endif
+        for (std::size_t i = first; i < nbFast; i++){ //Unpack
+            const std::size_t bit = i * width;
+            uint64_t word;
+            memcpy(&word, packed + bit / 8, sizeof(uint64_t));
+            values[i] = (Unsigned)((word >> (bit % 8)) & mask);
+        }
+        for (std::size_t i = std::max(nbFast, first); i < size; i++){ //The last ones
+            const std::size_t bit = i * width;
+            uint64_t word = 0;
+            memcpy(&word, packed + bit / 8, nbPacked - bit / 8);
+            values[i] = (Unsigned)((word >> (bit % 8)) & mask);
+        }
+        T previous = first ? out[first - 1] : 0;
+        for (std::size_t i = first; i < size; i++) previous = out[i] = Zigzag<T>::decode(values[i], previous); //Prefix sum
+    }
+};
+
+} // namespace pFactory
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef collectives_H
+#define collectives_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "Eventcounts.h"
+
+namespace pFactory
+{
+
+/*
+ * The state of the collective operations of a group (see Group::allreduce(), Group::reduce(), Group::allgather()
+ * and Group::broadcast()).
+ * The threads are the nodes of a tree rooted at the thread 0 in which each subtree is a range of consecutive threads
+ * (so a reduction follows the order of the threads and the operator only has to be associative).
+ * An operation goes up the tree (each thread combines the values of its children with its own one) then down
+ * (each thread takes the result of its parent): a thread only waits for its children and its parent.
+ * Each thread has its own slot (on its own cache lines) with two buffers of maxBytes bytes per direction, used
+ * alternately by consecutive operations: no allocation during an operation. A waiting thread sleeps on its slot and
+ * is only woken up by its children and its parent.
+ */
+class Collectives
+{
+public:
+    static const std::size_t maxBytes = 256; /* The maximum size of the data of an operation */
+    static const unsigned int arity = 4;     /* The maximum number of children of a thread */
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> up;   /* The number of operations for which this subtree is combined */
+        std::atomic<uint64_t> down; /* The number of operations for which this thread has the result */
+        uint64_t nbOperations;      /* The number of operations started by this thread (only used by this thread) */
+        EventCount published;       /* This thread sleeps until one of its children or its parent publishes */
+        alignas(16) unsigned char upData[2][maxBytes];
+        alignas(16) unsigned char downData[2][maxBytes];
+    };
+
+    explicit Collectives(unsigned int pnbThreads);
+
+    Collectives(const Collectives&) = delete;
+    Collectives& operator=(const Collectives&) = delete;
+
+    /* Forget the operations done (when the threads of the group are created again)
+    */
+    void reset();
+
+    inline unsigned int getNbThreads() const {return nbThreads;}
+    inline Slot& getSlot(unsigned int threadId) {return slots[threadId];}
+    inline unsigned int getParent(unsigned int threadId) const {return parents[threadId];}
+    inline const std::vector<unsigned int>& getChildren(unsigned int threadId) const {return children[threadId];}
+    inline unsigned int getNbSpins() const {return nbSpins;}
+
+private:
+    unsigned int nbThreads;
+    unsigned int nbSpins; /* The number of checks before sleeping (0 if there are more threads than cores) */
+    std::vector<Slot> slots;
+    std::vector<unsigned int> parents;
+    std::vector<std::vector<unsigned int>> children;
+
+    /* Build the subtree of the threads [first, end) rooted at first */
+    void build(unsigned int first, unsigned int end);
+};
+
+/* How the values of the children are combined with the value of a thread */
+template <class T, class Op>
+struct ReduceCombine
+{
+    Op op;
+    inline void operator()(T& value, const T& child) const {value = op(value, child);}
+};
+
+template <class T>
+struct GatherCombine
+{
+    inline void operator()(T&, const T&) const {}
+};
+
+/* The value of a broadcast: only the root has a value */
+template <class T>
+struct Broadcasted
+{
+    T value;
+    bool hasValue;
+};
+
+template <class T>
+struct BroadcastCombine
+{
+    inline void operator()(Broadcasted<T>& value, const Broadcasted<T>& child) const {if (!value.hasValue && child.hasValue) value = child;}
+};
+
+/*
+ * A collective operation of a thread in progress: test() does what can be done without waiting (a non-blocking
+ * operation is polled with test() between two pieces of work), wait() waits until the end.
+ * Warning: the threads of a group start the same operations in the same order, and a thread ends an operation
+ * before starting the next one
+ */
+template <class T, class Combine>
+class CollectiveRequest
+{
+    static_assert(std::is_trivially_copyable<T>::value, "The collective operations need a trivially copyable type");
+    static_assert(sizeof(T) <= Collectives::maxBytes, "The collective operations need a type of at most Collectives::maxBytes bytes");
+
+public:
+    /* \param pvalues For an allgather, where to copy the values of all threads (NULL otherwise)
+    */
+    CollectiveRequest(Collectives& pcollectives, unsigned int pthreadId, const T& value, const Combine& pcombine, T* pvalues = NULL)
+        : collectives(&pcollectives),
+          threadId(pthreadId),
+          combine(pcombine),
+          accumulator(value),
+          result(value),
+          values(pvalues),
+          nbChildren(0),
+          combined(false),
+          finished(false)
+    {
+        Collectives::Slot& slot = collectives->getSlot(threadId);
+        sequence = slot.nbOperations++;
+        parity = sequence & 1;
+    }
+
+    /* Progress without waiting
+       \return true if the operation is finished
+    */
+    inline bool test()
+    {
+        if (finished) return true;
+        Collectives::Slot& slot = collectives->getSlot(threadId);
+        const uint64_t target = sequence + 1;
+        if (!combined){ //Up: combine the subtrees of the children in the order of the threads
+            const std::vector<unsigned int>& threadChildren = collectives->getChildren(threadId);
+            for (; nbChildren < threadChildren.size(); nbChildren++){
+                Collectives::Slot& child = collectives->getSlot(threadChildren[nbChildren]);
+                if (child.up.load(std::memory_order_acquire) < target) return false;
+                T value;
+                memcpy(&value, child.upData[parity], sizeof(T));
+                combine(accumulator, value);
+            }
+            memcpy(slot.upData[parity], &accumulator, sizeof(T));
+            slot.up.store(target, std::memory_order_release);
+            if (threadId != 0) collectives->getSlot(collectives->getParent(threadId)).published.notifyAll();
+            combined = true;
+        }
+        //Down: take the result of the parent
+        if (threadId == 0) result = accumulator;
+        else{
+            Collectives::Slot& parent = collectives->getSlot(collectives->getParent(threadId));
+            if (parent.down.load(std::memory_order_acquire) < target) return false;
+            memcpy(&result, parent.downData[parity], sizeof(T));
+        }
+        memcpy(slot.downData[parity], &result, sizeof(T));
+        slot.down.store(target, std::memory_order_release);
+        for (unsigned int child : collectives->getChildren(threadId)) collectives->getSlot(child).published.notifyAll();
+        if (values) //The value of each thread is in its slot until the next operation with this parity
+            for (unsigned int i = 0; i < collectives->getNbThreads(); i++) memcpy(&values[i], collectives->getSlot(i).upData[parity], sizeof(T));
+        finished = true;
+        return true;
+    }
+
+    /* Spin for a bounded time, then sleep until the end of the operation
+    */
+    inline void wait()
+    {
+        for (unsigned int i = 0; i < collectives->getNbSpins(); i++){
+            if (test()) return;
+            cpuRelax();
+        }
+        EventCount& published = collectives->getSlot(threadId).published;
+        while (!test()){
+            const uint32_t key = published.prepareWait();
+            if (test()){
+                published.cancelWait();
+                return;
+            }
+            published.wait(key, std::chrono::milliseconds(100));
+        }
+    }
+
+    /* The result of the operation (once finished): the combination of the values of all threads in their order
+       (for a broadcast, the value of the root)
+    */
+    inline const T& get() const {return result;}
+
+    inline bool isFinished() const {return finished;}
+
+private:
+    Collectives* collectives;
+    unsigned int threadId;
+    Combine combine;
+    T accumulator;
+    T result;
+    T* values;
+    uint64_t sequence;
+    unsigned int parity;
+    unsigned int nbChildren; /* The children already combined */
+    bool combined;
+    bool finished;
+};
+
+} // namespace pFactory
+
+#endif
@@ -18,9 +18,19 @@
 #ifndef communicators_H
 #define communicators_H
 
+#include <cstdlib>
 #include <initializer_list>
 #include <mutex>
+#include <new>
+#include <chrono>
+#include <condition_variable>
+#include <random>
+#include <type_traits>
 #include "Groups.h"
+#include "Topologies.h"
+#include "Eventcounts.h"
+#include "Metrics.h"
+#include "Traces.h"
 namespace pFactory
 {
 
@@ -36,6 +46,109 @@ public:
     int idThread;
 };
 
+/* Behaviour of send() when the queue of the sender is full (see Communicator::setCapacity()) */
+enum class OverflowPolicy{
+    dropOldest, // The oldest data of the queue is dropped: only the lagging receivers miss it
+    dropNewest, // The new data is dropped: all receivers miss it
+    block,      // send() waits until the slowest receiver frees some space (or until the group is stopped)
+                // Warning: a thread blocked in send() does not receive, mix it with trySend() when senders are also receivers
+};
+
+/* The queue of a sender for a trivially copyable type: the data are contiguous in memory, so a receiver copies
+   a range of data with a memcpy instead of one copy per data (see QueueStorage).
+   Only the operations of a std::deque used by a Communicator are provided: the data are popped at the front
+   (erase()) and added at the end (push_back(), insert()). The popped data are only skipped: the remaining ones are
+   moved to the front when they fill less than half of the used memory (so a data is moved once on average).
+*/
+template <class T>
+class ContiguousQueue
+{
+public:
+    typedef T* iterator;
+
+    ContiguousQueue() : head(0) {}
+
+    inline std::size_t size() const {return buffer.size() - head;}
+    inline T& operator[](std::size_t index) {return buffer[head + index];}
+    inline iterator begin() {return buffer.data() + head;}
+    inline iterator end() {return buffer.data() + buffer.size();}
+
+    inline void push_back(const T& element) {buffer.push_back(element);}
+
+    template <class InputIterator>
+    inline void insert(iterator position, InputIterator first, InputIterator last)
+    {
+        assert(position == end());
+        (void)position;
+        buffer.insert(buffer.end(), first, last);
+    }
+
+    inline iterator erase(iterator first, iterator last)
+    {
+        assert(first == begin() && last <= end());
+        head += last - first;
+        if (head == buffer.size()){
+            buffer.clear();
+            head = 0;
+        }else if (head >= buffer.size() - head){
+            buffer.erase(buffer.begin(), buffer.begin() + head);
+            head = 0;
+        }
+        return begin();
+    }
+
+    inline void clear()
+    {
+        buffer.clear();
+        head = 0;
+    }
+
+private:
+    std::vector<T> buffer;
+    std::size_t head; /* The index in buffer of the first data */
+};
+
+/* An allocator on cache lines: std::allocator does not honor the alignment of an alignas(64) type in C++11
+   (a std::vector of such elements may then share cache lines with its neighbors)
+*/
+template <class T>
+struct CacheAlignedAllocator
+{
+    typedef T value_type;
+
+    CacheAlignedAllocator(){}
+    template <class U> CacheAlignedAllocator(const CacheAlignedAllocator<U>&){}
+
+    inline T* allocate(std::size_t n)
+    {
+        void* memory = NULL;
+        if (posix_memalign(&memory, std::max<std::size_t>(64, alignof(T)), n * sizeof(T)) != 0) throw std::bad_alloc();
+        return static_cast<T*>(memory);
+    }
+
+    inline void deallocate(T* memory, std::size_t){free(memory);}
+
+    template <class U> inline bool operator==(const CacheAlignedAllocator<U>&) const {return true;}
+    template <class U> inline bool operator!=(const CacheAlignedAllocator<U>&) const {return false;}
+};
+
+/* The queues of a Communicator: a ContiguousQueue for the trivially copyable types (except bool, whose std::vector
+   is not contiguous), a std::deque for the others
+*/
+template <class T, bool isContiguous = std::is_trivially_copyable<T>::value && !std::is_same<T, bool>::value>
+struct QueueStorage
+{
+    static const bool contiguous = false;
+    typedef std::deque<T> type;
+};
+
+template <class T>
+struct QueueStorage<T, true>
+{
+    static const bool contiguous = true;
+    typedef ContiguousQueue<T> type;
+};
+
 
 /*
  * To communicate between threads some information by copies.
@@ -44,23 +157,55 @@ template <class T>
 class Communicator
 {
 protected:
-    Group& group; /* Group of threads that have to communicate */ 
+    Group* group; /* Group of threads that have to communicate (see rebind()) */ 
     const unsigned int nbThreads; /* Number of threads */ 
 
+    /* Communicator between several groups (empty for one group): the groups and the index of their first thread */
+    /* The threads of all groups are numbered in the order of the groups */
+    std::vector<Group*> groups;
+    std::vector<unsigned int> groupOffsets;
+
     /* Used to know the allowed senders for the communications in the associated group */ 
     std::vector<bool> senders;
 
     /* Used to know the allowed receivers for the communications in the associated group */ 
     std::vector<bool> receivers;
 
+    /* For each receiver, the queues that it reads (all the senders by default, only its neighbors with a Topology)
+       Gossip topology: only changed by the receiver, under the mutex of its queue (the other threads read them under it) */
+    std::vector<std::vector<unsigned int>> neighbors;
+
+    /* True if the neighbors are given by a Topology */
+    bool hasTopology;
+
+    /* Gossip topology: number of neighbors re-drawn every gossipPeriod calls of recvAll() (0 if it is not a gossip topology) */
+    unsigned int gossipDegree;
+    unsigned int gossipPeriod;
+    std::vector<std::mt19937> generators; /* One random generator per thread */
+
+    /* Hub topology: the thread that forwards the data of the others (UINT_MAX if it is not a hub topology) */
+    unsigned int hubThread;
+
+    /* Hub topology: the thread that has sent each data of the queue of the hub (to not send a data back to its sender) */
+    std::deque<unsigned int> hubOrigins;
+
     /* Data to exchange : one std::deque per thread, the ith std::deque is the data sent by the ith thread */
-    std::vector<std::deque<T>> vectorOfQueues; 
+    /* (a ContiguousQueue for a trivially copyable type, see QueueStorage) */
+    typedef typename QueueStorage<T>::type DataQueue;
+    std::vector<DataQueue> vectorOfQueues;
 
     /* One mutex per queue */
     std::vector<std::mutex> threadMutexs;  
 
+    /* for each std::deque of data, the number of threads that receive its data */
+    std::vector<unsigned int> queuesNbReaders;
+
     /* for each std::deque of data, the position of each other thread (to know data already received) */
-    std::vector<std::vector<unsigned int>> threadQueuesPointer; 
+    /* Positions are absolute: the data at the position p is the data (p - base) of the std::deque */
+    std::vector<std::vector<std::size_t>> threadQueuesPointer; 
+
+    /* for each std::deque of data, the absolute position of its first data (increased when data are popped) */
+    std::vector<std::size_t> queuesBase;
 
     /* for each std::deque of data, to now the order of threads according to theirs positions (OrderPoiter* is a double linked list) */
     std::vector<std::vector<OrderPointer *>> threadOrdersPointer;
@@ -72,67 +217,545 @@ protected:
     std::vector<OrderPointer *> threadOrdersPointerEnd;
 
     /* For each std::deque, the smallest position of a thread (used to know if a thread is the last to recuperate some data) */
-    std::vector<unsigned int> minQueuesPointer;
+    std::vector<std::size_t> minQueuesPointer;
 
     /* For each std::deque, the second smallest position of a thread (so not the smallest :)) */
     /* Used to know, in the case where one thread is the last to recuperate some data, the limit of these last data */
-    std::vector<unsigned int> minSecondQueuesPointer;
+    std::vector<std::size_t> minSecondQueuesPointer;
+
+    /* Number of data received by all threads before popping them from a std::deque */
+    unsigned int reclaimThreshold;
+
+    /* Maximum number of data kept in each std::deque (0 means unbounded) */
+    unsigned int capacity;
+
+    /* What to do when a std::deque is full */
+    OverflowPolicy overflowPolicy;
+
+    /* One condition variable per queue: used by the OverflowPolicy::block policy to wake up a blocked sender */
+    std::vector<std::condition_variable> threadConditions;
+
+    /* for each std::deque of data, the number of data dropped before each other thread received them */
+    /* (a thread whose position is before the base of the std::deque has also missed base - position data) */
+    std::vector<std::vector<unsigned int>> threadQueuesDropped;
+
+    /* For each thread, the predicate used to select the data to receive (an empty std::function accepts all data) */
+    std::vector<std::function<bool(const T&)>> filters;
+
+    /* Receivers sleeping in recvWait() or recvAllWait() */
+    EventCount events;
 
-    
     std::vector<unsigned int> nbSend;
-    std::vector<unsigned int> nbRecv;
+    std::vector<std::atomic<unsigned int>> nbRecv; /* Per receiver, only written by the receiver (read without lock) */
     std::vector<unsigned int> nbRecvAll;
+    std::vector<std::atomic<unsigned int>> nbRejected; /* Per receiver, only written by the receiver (read without lock) */
+
+    /* Traffic metrics (see enableMetrics()): each thread writes the counters of its own shard with relaxed atomics,
+       the depth of a queue is written by the threads that hold its mutex (the sender and its receivers) */
+    struct alignas(64) MetricsShard
+    {
+        std::vector<std::atomic<uint64_t>> nbData;    /* Per sender, the data received by this thread */
+        std::vector<std::atomic<uint64_t>> nbBytes;
+        std::atomic<uint64_t> lockWait;
+        std::atomic<uint64_t> queueDepth;             /* Of the queue of this thread (written under its mutex) */
+        std::atomic<uint64_t> queueHighWater;
+        std::atomic<uint64_t> latencies[CommunicatorMetrics::nbBuckets];
+    };
+    bool withMetrics;
+    unsigned int samplingPeriod;
+    std::function<std::size_t(const T&)> dataSize;
+    std::vector<MetricsShard, CacheAlignedAllocator<MetricsShard>> metrics; /* One shard per cache line */
+    std::vector<std::deque<std::pair<std::size_t, int64_t>>> samples; /* Per queue, the send time of the sampled positions (under its mutex) */
+
+    /* Detached threads (see detach()) neither send nor receive, lagging readers are detached from a queue until their next receive */
+    std::vector<std::atomic<bool>> detached;
+    std::chrono::nanoseconds lagTimeout;
+    std::vector<std::atomic<int64_t>> lastReceive;
+    std::vector<std::pair<Group*, unsigned int>> taskListeners;
+
+    /* Throttle (see setImportBudget() and setExportControl()) */
+    unsigned int importBudget;
+    std::vector<std::size_t> roundRobin;
+    std::vector<std::vector<char>> activeQueues;
+    bool withExportControl;
+    double targetUsefulness;
+    double minExportRate;
+    std::vector<std::atomic<double>> exportRates;  /* Per sender, the fraction of its data that are sent */
+    std::vector<double> exportCredits;             /* Per sender, written by the sender only */
+    std::vector<std::atomic<uint64_t>> nbImported; /* Per sender, the feedback of the receivers */
+    std::vector<std::atomic<uint64_t>> nbUseful;
+    std::vector<unsigned int> nbThrottled;
+
+    /* Record of the traffic (see record()) */
+    TraceRecorder* recorder;
+    std::function<void(const T&, std::vector<uint8_t>&)> recordEncode;
+    std::vector<std::vector<uint8_t>> recordBytes; /* Per thread, the bytes of the last data sent */
 
     
 public:
     Communicator(Group& g, bool withInitialize=true);
     Communicator(Group& g, const std::vector<bool>& senders, const std::vector<bool>& receivers, bool withInitialize=true);
     Communicator(Group& g, std::initializer_list<unsigned int> p_senders, std::initializer_list<unsigned int> p_receivers, bool withInitialize=true);
+    Communicator(Group& g, const Topology& topology, bool withInitialize=true);
+
+    /* A communicator between several groups, the threads of all groups are numbered in the order of the groups
+          \param pgroups The groups
+          \param topology The neighbors of each thread (according to this numbering)
+        */
+    Communicator(const std::vector<Group*>& pgroups, const Topology& topology, bool withInitialize=true);
 
     void initialize();
 
-    ~Communicator();
+    /* The index of the calling thread in this communicator (its thread id for a communicator of one group)
+        */
+    inline unsigned int getThreadId()
+    {
+        if (groups.empty()) return group->getThreadId();
+        Group* current = Group::getCurrentGroup();
+        for (unsigned int i = 0; i < groups.size(); i++)
+            if (groups[i] == current) return groupOffsets[i] + current->getThreadId();
+        assert(false); // The calling thread does not belong to a group of this communicator
+        return UINT_MAX;
+    }
+
+    /* The group of the calling thread
+        */
+    inline Group& getCurrentGroup()
+    {
+        Group* current = groups.empty() ? NULL : Group::getCurrentGroup();
+        return current ? *current : *group;
+    }
+
+    /* The index of the thread threadId of the group g in this communicator
+        */
+    inline unsigned int getThreadId(const Group& g, unsigned int threadId) const
+    {
+        for (unsigned int i = 0; i < groups.size(); i++)
+            if (groups[i] == &g) return groupOffsets[i] + threadId;
+        return threadId;
+    }
+
+    virtual ~Communicator();
+
+    /* The number of threads of a communicator between several groups
+        */
+    static unsigned int countThreads(const std::vector<Group*>& pgroups);
+
+    /* An all-to-all communicator between several groups
+        */
+    Communicator(const std::vector<Group*>& pgroups, bool withInitialize=true);
 
     void createOrderPointer(unsigned int queue, unsigned int lenght);
     void deleteOrderPointer();
     void removePointer(unsigned int queue, unsigned int thread);
+    void addPointer(unsigned int queue, unsigned int thread);
 
    
     /*Send a data to others threads
           \param data Data to send
           Warning : user may pass a copŷ
+          Remark: if the queue of this thread is full (see setCapacity()), the OverflowPolicy of the communicator is applied
+          \return false if the data is not sent (this thread is not a sender or is detached, the data is throttled or dropped), true otherwise
         */
-    inline void send(T data)
+    virtual inline bool send(T data)
     {
-        const unsigned int threadId = group.getThreadId();
-        if (senders[threadId] == false){
+        const unsigned int threadId = getThreadId();
+        if (senders[threadId] == false || detached[threadId]){
             //printf("Warning: no data sent in a send() operation by a thread of a group that not is in the senders !");
-            return;
+            return false;
         } 
-        threadMutexs[threadId].lock();
-        vectorOfQueues[threadId].push_back(data);
+        if (withExportControl && !exportAllowed(threadId)) return false; //The data is throttled
+        lockQueue(threadId, threadId);
+        std::unique_lock<std::mutex> lock(threadMutexs[threadId], std::adopt_lock);
+        if (capacity && !makeRoom(threadId, lock)) return false; //The data is dropped
         //printf("send data of %d\n",threadId);
-        nbSend[threadId] += (nbThreads - 1);
-        threadMutexs[threadId].unlock();
+        if (recorder) recordSend(threadId, data); //Only the data accepted: a replay sends the same traffic
+        pushData(threadId, data, threadId);
+        lock.unlock();
+        events.notifyAll(); //Wake up the receivers sleeping in recvWait() or recvAllWait() (only an atomic load if none)
+        return true;
+    }
+
+    /*Send a data to others threads only if the queue of this thread is not full (never blocks nor drops data)
+          \param data Data to send
+          \return false if the data is not sent (queue full or this thread is not a sender), true otherwise
+        */
+    virtual inline bool trySend(T data)
+    {
+        const unsigned int threadId = getThreadId();
+        if (senders[threadId] == false || detached[threadId]) return false;
+        if (withExportControl && !exportAllowed(threadId)) return false; //The data is throttled
+        lockQueue(threadId, threadId);
+        std::unique_lock<std::mutex> lock(threadMutexs[threadId], std::adopt_lock);
+        DataQueue &deque = vectorOfQueues[threadId];
+        if (capacity && deque.size() >= capacity){
+            reclaim(threadId);
+            if (deque.size() >= capacity) return false;
+        }
+        if (recorder) recordSend(threadId, data);
+        pushData(threadId, data, threadId);
+        lock.unlock();
+        events.notifyAll();
+        return true;
+    }
+
+    /* Push a data in a queue (the mutex of the queue has to be locked)
+          Remark: the caller wakes up the sleeping receivers (events.notifyAll()) once the mutex is unlocked
+          \param origin The thread that has sent the data (differs from threadIdQueue only for data forwarded by a hub)
+        */
+    inline void pushData(unsigned int threadIdQueue, const T &data, unsigned int origin)
+    {
+        if (withMetrics && endPosition(threadIdQueue) % samplingPeriod == 0)
+            samples[threadIdQueue].push_back(std::make_pair(endPosition(threadIdQueue), nanoseconds()));
+        vectorOfQueues[threadIdQueue].push_back(data);
+        if (threadIdQueue == hubThread) hubOrigins.push_back(origin);
+        if (withMetrics) updateQueueDepth(threadIdQueue);
+        nbSend[threadIdQueue] += queuesNbReaders[threadIdQueue];
+        if (lagTimeout.count() && endPosition(threadIdQueue) % std::max(reclaimThreshold, 1u) == 0) detachLagging(threadIdQueue);
+    }
+
+    /* Bound the number of data kept in the queue of each sender
+          \param pcapacity Maximum number of data per queue (0 means unbounded, the default)
+          \param policy What send() does when the queue of the sender is full
+          Warning: has to be called before the computation of tasks
+        */
+    inline void setCapacity(unsigned int pcapacity, OverflowPolicy policy = OverflowPolicy::dropOldest)
+    {
+        capacity = pcapacity;
+        overflowPolicy = policy;
+    }
+
+    inline unsigned int getCapacity() const {return capacity;}
+
+    /* Set the number of data that all receivers must have received before popping them
+          \param threshold Small values free the memory sooner, large values pop less often but by larger blocks (default: 1000)
+        */
+    inline void setReclaimThreshold(unsigned int threshold){reclaimThreshold = threshold;}
+    inline unsigned int getReclaimThreshold() const {return reclaimThreshold;}
+
+    /* Register a filter for a receiver: a data is copied only if filter(data) is true, the others are skipped
+          \param threadId The receiver 
+          \param filter The predicate (an empty std::function removes the filter)
+          Remark: the filter is evaluated under the mutex of the sender, it has to be cheap (e.g. test the size of a clause)
+          Warning: has to be called before the computation of tasks or by the receiver itself
+        */
+    inline void setFilter(unsigned int threadId, const std::function<bool(const T&)> &filter){filters[threadId] = filter;}
+
+    /* Register a filter for the calling thread (see setFilter(unsigned int, filter))
+        */
+    inline void setFilter(const std::function<bool(const T&)> &filter){setFilter(getThreadId(), filter);}
+    inline OverflowPolicy getOverflowPolicy() const {return overflowPolicy;}
+
+    /* Collect traffic metrics (see getMetrics())
+          \param psamplingPeriod The send-to-receive latency is measured for one data out of psamplingPeriod of each sender
+          \param pdataSize The number of bytes of a data (sizeof(T) by default)
+          Warning: has to be called before the computation of tasks
+        */
+    inline void enableMetrics(unsigned int psamplingPeriod = 64, const std::function<std::size_t(const T&)> &pdataSize = nullptr)
+    {
+        withMetrics = true;
+        samplingPeriod = psamplingPeriod ? psamplingPeriod : 1;
+        dataSize = pdataSize;
+        metrics = std::vector<MetricsShard, CacheAlignedAllocator<MetricsShard>>(nbThreads);
+        for (MetricsShard &shard : metrics){
+            shard.nbData = std::vector<std::atomic<uint64_t>>(nbThreads);
+            shard.nbBytes = std::vector<std::atomic<uint64_t>>(nbThreads);
+            for (unsigned int i = 0; i < nbThreads; i++) shard.nbData[i] = shard.nbBytes[i] = 0;
+            shard.lockWait = shard.queueDepth = shard.queueHighWater = 0;
+            for (std::atomic<uint64_t> &bucket : shard.latencies) bucket = 0;
+        }
+        samples = std::vector<std::deque<std::pair<std::size_t, int64_t>>>(nbThreads);
+    }
+
+    /* A snapshot of the traffic metrics, without lock (enableMetrics() has to be called before)
+        */
+    inline CommunicatorMetrics getMetrics() const
+    {
+        CommunicatorMetrics ret(withMetrics ? nbThreads : 0);
+        for (unsigned int j = 0; j < ret.nbThreads; j++){
+            const MetricsShard &shard = metrics[j];
+            for (unsigned int i = 0; i < nbThreads; i++){
+                ret.nbData[i][j] = shard.nbData[i].load(std::memory_order_relaxed);
+                ret.nbBytes[i][j] = shard.nbBytes[i].load(std::memory_order_relaxed);
+            }
+            ret.queueDepth[j] = shard.queueDepth.load(std::memory_order_relaxed);
+            ret.queueHighWater[j] = shard.queueHighWater.load(std::memory_order_relaxed);
+            ret.lockWait[j] = shard.lockWait.load(std::memory_order_relaxed);
+            for (unsigned int b = 0; b < CommunicatorMetrics::nbBuckets; b++)
+                ret.latencies[j][b] = shard.latencies[b].load(std::memory_order_relaxed);
+        }
+        return ret;
+    }
+
+    /* Detach a thread: it neither sends nor receives and its position does not prevent the reclamation of the data of the other threads
+          \param threadId The thread (by default the calling thread)
+          Warning: has to be called by the thread itself or while it does not use this communicator
+        */
+    inline void detach(unsigned int threadId)
+    {
+        if (detached[threadId]) return;
+        detached[threadId] = true;
+        for (unsigned int threadIdQueue : neighbors[threadId]){
+            std::unique_lock<std::mutex> lock(threadMutexs[threadIdQueue]);
+            if (!isReader(threadIdQueue, threadId)) continue;
+            removePointer(threadIdQueue, threadId);
+            queuesNbReaders[threadIdQueue]--;
+            reclaim(threadIdQueue);
+            //Wake up a sender blocked on a full queue
+            if (capacity && overflowPolicy == OverflowPolicy::block) threadConditions[threadIdQueue].notify_all();
+        }
+    }
+    inline void detach(){detach(getThreadId());}
+
+    /* Attach again a detached thread: it receives the data sent from now on
+          \param threadId The thread (by default the calling thread)
+        */
+    inline void attach(unsigned int threadId)
+    {
+        if (!detached[threadId]) return;
+        for (unsigned int threadIdQueue : neighbors[threadId]){
+            std::unique_lock<std::mutex> lock(threadMutexs[threadIdQueue]);
+            if (isReader(threadIdQueue, threadId)) continue;
+            addPointer(threadIdQueue, threadId);
+            queuesNbReaders[threadIdQueue]++;
+        }
+        detached[threadId] = false;
+    }
+    inline void attach(){attach(getThreadId());}
+
+    inline bool isDetached(unsigned int threadId) const {return detached[threadId];}
+
+    /* Detach the threads at the end of each of their tasks (and when they leave their group), attach them at the start of a task
+          Warning: has to be called before the start of the groups
+        */
+    inline void setAutoDetach()
+    {
+        std::vector<Group*> allGroups = groups.empty() ? std::vector<Group*>(1, group) : groups;
+        for (Group* g : allGroups){
+            unsigned int listenerId = g->addTaskListener([this](unsigned int){attach(getThreadId());}, [this](unsigned int){detach(getThreadId());});
+            taskListeners.push_back(std::make_pair(g, listenerId));
+        }
+    }
+
+    /* A reader that has not received for timeout stops holding the data of a sender: when the queue of the sender grows,
+       it is detached from this queue. At its next receive, it resumes where it was and the reclaimed data are counted as dropped
+       (see getNbDropped())
+          \param timeout 0 (the default) disables the timeout
+          Warning: has to be called before the computation of tasks
+        */
+    inline void setLagTimeout(std::chrono::nanoseconds timeout)
+    {
+        lagTimeout = timeout;
+        const int64_t now = nanoseconds();
+        for (unsigned int i = 0; i < nbThreads; i++) lastReceive[i] = now;
+    }
+
+    /* Bound the number of data taken by a recvAll(): the budget is shared round-robin by the senders,
+       a sender that floods the receivers only gets its share (the rest stays in its queue for the next calls)
+          \param budget The maximum number of data per call of recvAll() (0, the default, means no limit)
+          Warning: has to be called before the computation of tasks
+        */
+    inline void setImportBudget(unsigned int budget){importBudget = budget;}
+    inline unsigned int getImportBudget() const {return importBudget;}
+
+    /* Adapt the export rate of each sender to the usefulness of its data reported by the receivers (see feedback()):
+       the rate grows when the usefulness reaches the target and decreases otherwise. send() sends only this fraction of the data.
+          \param ptargetUsefulness The expected ratio of useful data (in [0, 1])
+          \param pminExportRate The minimal export rate of a sender
+          Warning: has to be called before the computation of tasks
+        */
+    inline void setExportControl(double ptargetUsefulness, double pminExportRate = 0.05)
+    {
+        withExportControl = true;
+        targetUsefulness = ptargetUsefulness;
+        minExportRate = pminExportRate;
+    }
+
+    /* Report the usefulness of imported data
+          \param sender The sender of the data (see recvAll(data, origins))
+          \param nbImportedData The number of data evaluated
+          \param nbUsefulData The number of useful ones
+        */
+    inline void feedback(unsigned int sender, unsigned int nbImportedData, unsigned int nbUsefulData)
+    {
+        nbImported[sender].fetch_add(nbImportedData, std::memory_order_relaxed);
+        nbUseful[sender].fetch_add(nbUsefulData, std::memory_order_relaxed);
+    }
+
+    /* The fraction of the data of a sender that are sent (1 without export control)
+        */
+    inline double getExportRate(unsigned int sender) const {return exportRates[sender].load(std::memory_order_relaxed);}
+
+    /* The number of data not sent because of the export control
+        */
+    inline unsigned int getNbThrottled() const
+    {
+        unsigned int ret = 0;
+        for (unsigned int nb : nbThrottled) ret += nb;
+        return ret;
+    }
+
+    /* Record the traffic in a trace: the data sent (with their bytes, not the throttled or dropped ones), the calls of recvAll() and recv()
+       and the moves of the positions of the receivers (see TraceRecorder, TraceReader and replay())
+          \param precorder The recorder, of nbThreads threads
+          \param encode To get the bytes of a data (provided for the trivially copyable types and their std::vector)
+          Warning: has to be called before the computation of tasks
+        */
+    inline void record(TraceRecorder &precorder) {record(precorder, &TraceEncoding<T>::encode);}
+    inline void record(TraceRecorder &precorder, const std::function<void(const T&, std::vector<uint8_t>&)> &encode)
+    {
+        assert(precorder.getNbThreads() == nbThreads);
+        recorder = &precorder;
+        recordEncode = encode;
+        recordBytes = std::vector<std::vector<uint8_t>>(nbThreads);
+    }
+
+    inline void recordSend(unsigned int threadId, const T &data)
+    {
+        std::vector<uint8_t> &bytes = recordBytes[threadId];
+        recordEncode(data, bytes);
+        recorder->send(threadId, bytes.data(), bytes.size());
+    }
+
+    /* Start a new epoch (e.g. after Group::reload()) without reallocating the queues and the lists of pointers:
+       the queues, the positions, the detached threads and the counters are cleared.
+       The settings (topology, filters, capacity, metrics, budgets) and the learned export rates are kept.
+          \param carried The data carried over into the new epoch (e.g. the best lemmas): carried[i] is received
+          from the thread i by its receivers as if it was sent at the start of the epoch (empty by default)
+          Warning: has to be called while no thread uses this communicator
+        */
+    inline void reset(const std::vector<std::vector<T>> &carried = std::vector<std::vector<T>>())
+    {
+        assert(carried.empty() || carried.size() == nbThreads);
+        for (unsigned int i = 0; i < nbThreads; i++){
+            DataQueue &deque = vectorOfQueues[i];
+            deque.clear();
+            if (i == hubThread) hubOrigins.clear();
+            if (!carried.empty() && senders[i]){
+                deque.insert(deque.end(), carried[i].begin(), carried[i].end());
+                if (i == hubThread) hubOrigins.insert(hubOrigins.end(), carried[i].size(), hubThread);
+            }
+            queuesBase[i] = 0;
+            minQueuesPointer[i] = minSecondQueuesPointer[i] = 0;
+            nbSend[i] = nbRecv[i] = nbRecvAll[i] = nbRejected[i] = 0;
+            if (withMetrics) samples[i].clear();
+        }
+        //Each receiver reads again all its neighbors from the start
+        for (unsigned int j = 0; j < nbThreads; j++){
+            detached[j] = false;
+            for (unsigned int i : neighbors[j]){
+                if (!isReader(i, j)){
+                    addPointer(i, j);
+                    queuesNbReaders[i]++;
+                }
+                threadQueuesPointer[i][j] = 0;
+                threadQueuesDropped[i][j] = 0;
+            }
+        }
+        const int64_t now = nanoseconds();
+        for (unsigned int i = 0; i < nbThreads; i++){
+            lastReceive[i] = now;
+            roundRobin[i] = 0;
+            exportCredits[i] = 0;
+            nbImported[i] = nbUseful[i] = 0;
+            nbThrottled[i] = 0;
+        }
+        if (withMetrics){
+            for (MetricsShard &shard : metrics){
+                for (unsigned int i = 0; i < nbThreads; i++) shard.nbData[i] = shard.nbBytes[i] = 0;
+                shard.lockWait = shard.queueDepth = shard.queueHighWater = 0;
+                for (std::atomic<uint64_t> &bucket : shard.latencies) bucket = 0;
+            }
+            for (unsigned int i = 0; i < nbThreads; i++) metrics[i].queueDepth = metrics[i].queueHighWater = vectorOfQueues[i].size();
+        }
+    }
+
+    /* Start a new epoch with another group of the same size (see reset())
+          \param g The new group
+          \param carried The data carried over into the new epoch
+          Warning: only for a communicator of one group, has to be called while no thread uses this communicator
+        */
+    inline void rebind(Group& g, const std::vector<std::vector<T>> &carried = std::vector<std::vector<T>>())
+    {
+        assert(groups.empty() && g.getNbThreads() == nbThreads);
+        if (&g != group){
+            //Move the listeners of setAutoDetach() to the new group
+            for (std::pair<Group*, unsigned int> &listener : taskListeners){
+                listener.first->removeTaskListener(listener.second);
+                listener = std::make_pair(&g, g.addTaskListener([this](unsigned int){attach(getThreadId());}, [this](unsigned int){detach(getThreadId());}));
+            }
+            group = &g;
+        }
+        reset(carried);
+    }
+
+    /* A counter written by a single thread: no atomic read-modify-write
+        */
+    template <class C>
+    static inline void addRelaxed(std::atomic<C> &counter, typename std::common_type<C>::type value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static inline int64_t nanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /* Lock the mutex of a queue, measure the waiting time of threadId if it is taken
+        */
+    inline void lockQueue(unsigned int threadIdQueue, unsigned int threadId)
+    {
+        std::mutex &mutex = threadMutexs[threadIdQueue];
+        if (!withMetrics){
+            mutex.lock();
+            return;
+        }
+        if (mutex.try_lock()) return;
+        const int64_t start = nanoseconds();
+        mutex.lock();
+        addRelaxed(metrics[threadId].lockWait, nanoseconds() - start);
+    }
+
+    /* The queue has changed (the mutex of the queue has to be locked)
+        */
+    inline void updateQueueDepth(unsigned int threadIdQueue)
+    {
+        MetricsShard &shard = metrics[threadIdQueue];
+        const uint64_t depth = vectorOfQueues[threadIdQueue].size();
+        shard.queueDepth.store(depth, std::memory_order_relaxed);
+        uint64_t highWater = shard.queueHighWater.load(std::memory_order_relaxed);
+        while (depth > highWater && !shard.queueHighWater.compare_exchange_weak(highWater, depth, std::memory_order_relaxed));
+        //Forget the samples of the popped data
+        std::deque<std::pair<std::size_t, int64_t>> &queueSamples = samples[threadIdQueue];
+        while (!queueSamples.empty() && queueSamples.front().first < queuesBase[threadIdQueue]) queueSamples.pop_front();
+    }
+
+    /* Measure the latency of the sampled data at the positions [from, to) received by threadId (the mutex of the queue has to be locked)
+        */
+    inline void sampleLatencies(unsigned int threadIdQueue, unsigned int threadId, std::size_t from, std::size_t to)
+    {
+        std::deque<std::pair<std::size_t, int64_t>> &queueSamples = samples[threadIdQueue];
+        if (queueSamples.empty() || from >= to || queueSamples.back().first < from) return;
+        const int64_t now = nanoseconds();
+        std::deque<std::pair<std::size_t, int64_t>>::iterator it = std::lower_bound(queueSamples.begin(), queueSamples.end(), std::make_pair(from, (int64_t)INT64_MIN));
+        for (; it != queueSamples.end() && it->first < to; ++it)
+            addRelaxed(metrics[threadId].latencies[CommunicatorMetrics::bucket(now - it->second)], 1);
     }
 
     /* Say if there are data to recuperate
          */
     inline bool isEmpty()
     {
-        const unsigned int threadId = group.getThreadId();
-        for (unsigned int threadIdQueue = 0; threadIdQueue < nbThreads; threadIdQueue++)
+        const unsigned int threadId = getThreadId();
+        if (!receivers[threadId] || detached[threadId]) return true;
+        //Browse the queues of the neighbors of this thread (all other senders by default)
+        for (unsigned int threadIdQueue : neighbors[threadId])
         {
-            //Browse all queue except the queue of this thread
-            if (threadIdQueue != threadId)
-            {
-                //These adresses don't move, so no mutex here !
-                std::deque<T> &deque = vectorOfQueues[threadIdQueue];
-                std::vector<unsigned int> &queuePointer = threadQueuesPointer[threadIdQueue];
-                if (deque.empty() || queuePointer[threadId] == deque.size())
-                    continue;
-                return false;
-            }
+            //These adresses don't move, so no mutex here !
+            if (threadQueuesPointer[threadIdQueue][threadId] >= endPosition(threadIdQueue))
+                continue;
+            return false;
         }
         return true;
     }
@@ -159,21 +782,411 @@ public:
         threadOrdersPointerEnd[threadIdQueue]->previous = ordersPointer[threadId];           //Push back in the queue
     }
 
+    /* Say if the thread is a receiver of the queue threadIdQueue
+    */
+    inline bool isReader(unsigned int threadIdQueue, unsigned int thread){
+        return threadOrdersPointer[threadIdQueue][thread] != NULL;
+    }
+
+    /* Absolute position of the end of the queue threadIdQueue
+    */
+    inline std::size_t endPosition(unsigned int threadIdQueue){
+        return queuesBase[threadIdQueue] + vectorOfQueues[threadIdQueue].size();
+    }
+
+    /* Position of the thread in the queue threadIdQueue, the dropped data are skipped (the mutex of the queue has to be locked)
+    */
+    inline std::size_t position(unsigned int threadIdQueue, unsigned int thread){
+        return std::max(threadQueuesPointer[threadIdQueue][thread], queuesBase[threadIdQueue]);
+    }
+
+    /* Move the thread after the data dropped in the queue threadIdQueue and count them (the mutex of the queue has to be locked)
+    */
+    inline void skipDropped(unsigned int threadIdQueue, unsigned int thread){
+        std::size_t &pointer = threadQueuesPointer[threadIdQueue][thread];
+        if (pointer < queuesBase[threadIdQueue]){
+            threadQueuesDropped[threadIdQueue][thread] += queuesBase[threadIdQueue] - pointer;
+            pointer = queuesBase[threadIdQueue];
+        }
+    }
+
+    /*  Update the ordersPointer after a partial receive (move the current thread after the threads with a smaller or equal position)
+        The ordersPointer stays sorted, so the minimum and the second minimum remain the first elements
+    */
+    inline void advanceOrdersPointer(std::vector<OrderPointer *> &ordersPointer, unsigned int threadIdQueue, unsigned int threadId){
+        OrderPointer *current = ordersPointer[threadId];
+        OrderPointer *after = current->next;
+        const std::size_t currentPosition = position(threadIdQueue, threadId);
+        while (after->idThread != -1 && position(threadIdQueue, after->idThread) <= currentPosition)
+            after = after->next;
+        if (after == current->next) return;
+        current->next->previous = current->previous; //Removing in the queue
+        current->previous->next = current->next;     //Removing in the queue
+        current->next = after;                       //Insert before after
+        current->previous = after->previous;         //Insert before after
+        after->previous->next = current;             //Insert before after
+        after->previous = current;                   //Insert before after
+    }
+
+    /*
+    *   Pop all data before minQueuePointer (already received by all threads)
+    *   Positions are absolute: only the base moves, the positions of the threads are not modified
+    *   and the blocks of the std::deque are freed at once
+    */
+    inline void popDataReceived(std::size_t minQueuePointer, unsigned int threadIdQueue){
+        DataQueue &deque = vectorOfQueues[threadIdQueue];
+        std::size_t &base = queuesBase[threadIdQueue];
+        if (minQueuePointer <= base) return;
+        deque.erase(deque.begin(), deque.begin() + (minQueuePointer - base));
+        if (threadIdQueue == hubThread) hubOrigins.erase(hubOrigins.begin(), hubOrigins.begin() + (minQueuePointer - base));
+        base = minQueuePointer;
+        if (withMetrics) updateQueueDepth(threadIdQueue);
+    }
+
+    /*
+    *   Pop all data already received by all threads (exact minimum, the mutex of the queue has to be locked)
+    */
+    inline void reclaim(unsigned int threadIdQueue){
+        std::size_t minQueuePointer = endPosition(threadIdQueue);
+        for (unsigned int j = 0; j < threadOrdersPointer[threadIdQueue].size(); j++)
+            if (isReader(threadIdQueue, j) && position(threadIdQueue, j) < minQueuePointer)
+                minQueuePointer = position(threadIdQueue, j);
+        popDataReceived(minQueuePointer, threadIdQueue);
+    }
+
     /*
-    *   Pop all data already received by all threads (based on a heuristic)
+    *   Drop the nb oldest data of a queue, the receivers that have not received them yet miss them (the mutex of the queue has to be locked)
+    *   The missed data are counted when these receivers catch up (see skipDropped())
+    */
+    inline void dropFront(unsigned int threadIdQueue, std::size_t nb){
+        DataQueue &deque = vectorOfQueues[threadIdQueue];
+        deque.erase(deque.begin(), deque.begin() + nb);
+        if (threadIdQueue == hubThread) hubOrigins.erase(hubOrigins.begin(), hubOrigins.begin() + nb);
+        queuesBase[threadIdQueue] += nb;
+        if (withMetrics) updateQueueDepth(threadIdQueue);
+    }
+
+    /*
+    *   Count a new data dropped for all the receivers of a queue (the mutex of the queue has to be locked)
+    */
+    inline void dropNew(unsigned int threadIdQueue){
+        for (unsigned int j = 0; j < threadOrdersPointer[threadIdQueue].size(); j++)
+            if (isReader(threadIdQueue, j)) threadQueuesDropped[threadIdQueue][j]++;
+    }
+
+    /*
+    *   Apply the OverflowPolicy on a full queue before a send (the mutex of the queue is locked by lock)
+    *   \return false if the new data has to be dropped, true otherwise
+    */
+    inline bool makeRoom(unsigned int threadIdQueue, std::unique_lock<std::mutex> &lock){
+        DataQueue &deque = vectorOfQueues[threadIdQueue];
+        if (deque.size() < capacity) return true;
+        //First, pop data already received by all threads
+        reclaim(threadIdQueue);
+        switch (overflowPolicy){
+            case OverflowPolicy::dropOldest:
+                if (deque.size() >= capacity) dropFront(threadIdQueue, deque.size() - capacity + 1);
+                return true;
+            case OverflowPolicy::dropNewest:
+                if (deque.size() < capacity) return true;
+                dropNew(threadIdQueue);
+                return false;
+            case OverflowPolicy::block:
+                while (deque.size() >= capacity){
+                    if (getCurrentGroup().isStopped()){ //Never block a stopped group
+                        dropNew(threadIdQueue);
+                        return false;
+                    }
+                    //Timeout: the stop of a group is not notified
+                    threadConditions[threadIdQueue].wait_for(lock, std::chrono::milliseconds(10));
+                    reclaim(threadIdQueue);
+                }
+                return true;
+        }
+        return true;
+    }
+
+    /* Hub topology: say if the data at the index of the queue threadIdQueue has been sent by the thread (so it is not received again)
+    */
+    inline bool isEcho(unsigned int threadIdQueue, unsigned int threadId, std::size_t index){
+        return threadIdQueue == hubThread && hubOrigins[index] == threadId;
+    }
+
+    /* Hub topology: forward to all other threads some data received by the hub from the thread origin
+    */
+    inline void relay(unsigned int origin, const std::vector<T> &data, std::size_t from){
+        std::unique_lock<std::mutex> lock(threadMutexs[hubThread]);
+        for (std::size_t i = from; i < data.size(); i++){
+            if (capacity && !makeRoom(hubThread, lock)) continue; //The data is dropped
+            pushData(hubThread, data[i], origin);
+        }
+        lock.unlock();
+        events.notifyAll();
+    }
+    inline void relay(unsigned int origin, const T &data){
+        std::unique_lock<std::mutex> lock(threadMutexs[hubThread]);
+        if (capacity && !makeRoom(hubThread, lock)) return; //The data is dropped
+        pushData(hubThread, data, origin);
+        lock.unlock();
+        events.notifyAll();
+    }
+
+    /* Say if the sender can send its next data according to its export rate (called by the sender only)
+        */
+    inline bool exportAllowed(unsigned int sender){
+        //Adapt the rate when enough feedback is received
+        static const uint64_t window = 64;
+        if (nbImported[sender].load(std::memory_order_relaxed) >= window){
+            const double imported = (double)nbImported[sender].exchange(0, std::memory_order_relaxed);
+            const double useful = (double)nbUseful[sender].exchange(0, std::memory_order_relaxed);
+            const double rate = exportRates[sender].load(std::memory_order_relaxed);
+            exportRates[sender].store(useful >= targetUsefulness * imported ? std::min(1.0, rate * 1.25) : std::max(minExportRate, rate * 0.8), std::memory_order_relaxed);
+        }
+        double &credit = exportCredits[sender];
+        credit += exportRates[sender].load(std::memory_order_relaxed);
+        if (credit >= 1){
+            credit -= 1;
+            return true;
+        }
+        nbThrottled[sender]++;
+        return false;
+    }
+    /* Detach the lagging readers of a queue (the mutex of the queue has to be locked)
+        */
+    inline void detachLagging(unsigned int threadIdQueue){
+        const int64_t limit = nanoseconds() - lagTimeout.count();
+        bool changed = false;
+        //The readers at the smallest positions are the first of the list
+        for (OrderPointer *pointer = threadOrdersPointerStart[threadIdQueue]->next; pointer->idThread != -1;){
+            OrderPointer *next = pointer->next;
+            if (lastReceive[pointer->idThread].load(std::memory_order_relaxed) < limit){
+                removePointer(threadIdQueue, pointer->idThread);
+                queuesNbReaders[threadIdQueue]--;
+                changed = true;
+            }
+            pointer = next;
+        }
+        if (changed) reclaim(threadIdQueue);
+    }
+    /* A reader detached from a queue because it was lagging receives again (the mutex of the queue has to be locked)
+           Its pointer is kept: the data reclaimed meanwhile are counted as dropped by skipDropped()
+        */
+    inline void resume(unsigned int threadIdQueue, unsigned int threadId){
+        const std::size_t current = position(threadIdQueue, threadId);
+        OrderPointer *before = threadOrdersPointerStart[threadIdQueue]->next;
+        while (before->idThread != -1 && position(threadIdQueue, before->idThread) <= current) before = before->next;
+        OrderPointer *pointer = new OrderPointer(threadId);
+        pointer->next = before;
+        pointer->previous = before->previous;
+        before->previous->next = pointer;
+        before->previous = pointer;
+        threadOrdersPointer[threadIdQueue][threadId] = pointer;
+        queuesNbReaders[threadIdQueue]++;
+    }
+    /* Gossip topology: the thread reads the queues of degree new random senders
+           (the data sent before the thread becomes a neighbor are not received)
+    */
+    inline void reshuffle(unsigned int threadId){
+        std::vector<unsigned int> candidates;
+        for (unsigned int threadIdQueue = 0; threadIdQueue < nbThreads; threadIdQueue++)
+            if (threadIdQueue != threadId && senders[threadIdQueue]) candidates.push_back(threadIdQueue);
+        std::shuffle(candidates.begin(), candidates.end(), generators[threadId]);
+        if (candidates.size() > gossipDegree) candidates.resize(gossipDegree);
+        std::vector<unsigned int> &oldNeighbors = neighbors[threadId];
+        for (unsigned int threadIdQueue : oldNeighbors){
+            if (std::find(candidates.begin(), candidates.end(), threadIdQueue) != candidates.end()) continue;
+            std::unique_lock<std::mutex> lock(threadMutexs[threadIdQueue]);
+            if (!isReader(threadIdQueue, threadId)) continue; //Already detached (lagging reader)
+            removePointer(threadIdQueue, threadId);
+            queuesNbReaders[threadIdQueue]--;
+            //Wake up a sender blocked on a full queue
+            if (capacity && overflowPolicy == OverflowPolicy::block) threadConditions[threadIdQueue].notify_all();
+        }
+        for (unsigned int threadIdQueue : candidates){
+            if (std::find(oldNeighbors.begin(), oldNeighbors.end(), threadIdQueue) != oldNeighbors.end()) continue;
+            std::unique_lock<std::mutex> lock(threadMutexs[threadIdQueue]);
+            addPointer(threadIdQueue, threadId);
+            queuesNbReaders[threadIdQueue]++;
+        }
+        std::lock_guard<std::mutex> lock(threadMutexs[threadId]); //getNbDropped() reads the neighbors of this thread
+        oldNeighbors.swap(candidates);
+    }
+
+    /* Say if the thread has to receive a data according to its filter (see setFilter()) and count it
     */
-    inline void popDataReceived(unsigned int minQueuePointer, unsigned int threadIdQueue, std::vector<unsigned int> &queuePointer, std::deque<T> &deque){
-        for (unsigned int i = 0; i < minQueuePointer; i++)
+    inline bool accept(unsigned int threadIdQueue, unsigned int threadId, const T &element){
+        if (!filters[threadId] || filters[threadId](element)){
+            addRelaxed(nbRecv[threadId], 1);
+            if (withMetrics){
+                addRelaxed(metrics[threadId].nbData[threadIdQueue], 1);
+                addRelaxed(metrics[threadId].nbBytes[threadIdQueue], dataSize ? dataSize(element) : sizeof(T));
+            }
+            return true;
+        }
+        addRelaxed(nbRejected[threadId], 1);
+        return false;
+    }
+
+    /* Receive the data of the queue threadIdQueue from the position of the thread threadId to the position to
+       (the mutex of the queue has to be locked)
+           \param nbTaken The number of data received, at most limit
+        */
+    inline void recvRange(unsigned int threadIdQueue, unsigned int threadId, std::size_t to, std::vector<T> &data, std::size_t limit, std::size_t &nbTaken)
+    {
+        recvRange(threadIdQueue, threadId, to, data, limit, nbTaken, std::integral_constant<bool, QueueStorage<T>::contiguous>());
+    }
+
+    /* One copy per data */
+    inline void recvRange(unsigned int threadIdQueue, unsigned int threadId, std::size_t to, std::vector<T> &data, std::size_t limit, std::size_t &nbTaken, std::false_type)
+    {
+        DataQueue &deque = vectorOfQueues[threadIdQueue];
+        std::size_t &pointer = threadQueuesPointer[threadIdQueue][threadId];
+        const std::size_t base = queuesBase[threadIdQueue];
+        while (pointer != to && nbTaken < limit)
         {
-            for (unsigned int j = 0; j < nbThreads; j++){
-                // Update queuePointer
-                if (j != threadIdQueue) 
-                    queuePointer[j]--;
+            const std::size_t index = pointer++ - base;
+            if (isEcho(threadIdQueue, threadId, index)) continue;
+            if (accept(threadIdQueue, threadId, deque[index])){
+                data.push_back(deque[index]);
+                nbTaken++;
+            }
+        }
+    }
+
+    /* Contiguous data: one memcpy for the range and one update of the position (unless a data has to be checked)
+    */
+    inline void recvRange(unsigned int threadIdQueue, unsigned int threadId, std::size_t to, std::vector<T> &data, std::size_t limit, std::size_t &nbTaken, std::true_type)
+    {
+        if (filters[threadId] || threadIdQueue == hubThread || (withMetrics && dataSize)){
+            recvRange(threadIdQueue, threadId, to, data, limit, nbTaken, std::false_type());
+            return;
+        }
+        std::size_t &pointer = threadQueuesPointer[threadIdQueue][threadId];
+        const std::size_t nb = std::min(to - pointer, limit - nbTaken);
+        if (nb == 0) return;
+        const T *first = &vectorOfQueues[threadIdQueue][pointer - queuesBase[threadIdQueue]];
+        data.insert(data.end(), first, first + nb);
+        pointer += nb;
+        nbTaken += nb;
+        addRelaxed(nbRecv[threadId], nb);
+        if (withMetrics){
+            addRelaxed(metrics[threadId].nbData[threadIdQueue], nb);
+            addRelaxed(metrics[threadId].nbBytes[threadIdQueue], nb * sizeof(T));
+        }
+    }
+
+    /* Receive the data of the queue threadIdQueue not yet received by the thread threadId
+           \param dataNotLast Elements which have not been received by all threads
+           \param dataLast Elements which have been received by all threads
+           \param limit The maximum number of data to receive
+           \return true if all data of the queue are received
+    */
+    inline bool recvQueue(unsigned int threadIdQueue, unsigned int threadId, std::vector<T> &dataNotLast, std::vector<T> &dataLast, bool withDataLast, std::size_t limit = SIZE_MAX)
+    {
+        //These adresses don't move, so no mutex here !
+        std::vector<std::size_t> &queuePointer = threadQueuesPointer[threadIdQueue];
+        //Special issue if the watch of thread is at the end (no clause to recuperate)
+        if (queuePointer[threadId] >= endPosition(threadIdQueue))
+        {
+            return true;
+        }
+
+        std::mutex &mutex = threadMutexs[threadIdQueue];
+        std::size_t &minQueuePointer = minQueuesPointer[threadIdQueue];
+        std::size_t &minSecondQueuePointer = minSecondQueuesPointer[threadIdQueue];
+        std::vector<OrderPointer *> &ordersPointer = threadOrdersPointer[threadIdQueue];
+
+        lockQueue(threadIdQueue, threadId);
+
+        //This thread may have been detached from this queue (lagging reader)
+        if (!isReader(threadIdQueue, threadId)) resume(threadIdQueue, threadId);
+
+        //Verify the queue of pointers
+        assertQueuePointerCriticalSection(threadIdQueue);
+
+        //Skip the data dropped by a full queue
+        skipDropped(threadIdQueue, threadId);
+        const std::size_t base = queuesBase[threadIdQueue];
+        const std::size_t end = endPosition(threadIdQueue);
+        const std::size_t start = queuePointer[threadId];
+        std::size_t nbTaken = 0;
+
+        //Get the minimum and the second minimum !
+        minQueuePointer = position(threadIdQueue, threadOrdersPointerStart[threadIdQueue]->next->idThread);
+
+        if (withDataLast){
+            int idSecondQueuePointer = threadOrdersPointerStart[threadIdQueue]->next->next->idThread;
+            minSecondQueuePointer = (idSecondQueuePointer == -1) ? end : position(threadIdQueue, idSecondQueuePointer);
+
+            //Recuperate clauses that I have to no copy : it is the dataLast thread that take these clauses
+            if (minQueuePointer == queuePointer[threadId])
+            { //I am a minumum : there are may be dataLast clauses with no copy (this thread is at the smallest position)
+                recvRange(threadIdQueue, threadId, minSecondQueuePointer, dataLast, limit, nbTaken); // warning, that can be equals (severals minimums equals)!
             }
-            deque.pop_front();
         }
+        //Now, recuperate clauses that I have to copy
+        recvRange(threadIdQueue, threadId, end, dataNotLast, limit, nbTaken);
+        const bool all = queuePointer[threadId] == end;
+        if (withMetrics) sampleLatencies(threadIdQueue, threadId, start, queuePointer[threadId]);
+        if (recorder && queuePointer[threadId] != start) recorder->advance(threadId, threadIdQueue, start, queuePointer[threadId]);
+
+        //Update the ordersPointer 
+        if (all)
+            updateOrdersPointer(ordersPointer, threadIdQueue, threadId); //No more clauses to recuperate: this thread is at the end
+        else
+            advanceOrdersPointer(ordersPointer, threadIdQueue, threadId);
+
+        //pop data already recuperate by all threads
+        if (minQueuePointer - base >= reclaimThreshold) popDataReceived(minQueuePointer, threadIdQueue);
+
+        //Wake up a sender blocked on a full queue
+        if (capacity && overflowPolicy == OverflowPolicy::block) threadConditions[threadIdQueue].notify_all();
+
+        mutex.unlock();
+        return all;
     }
 
+    /* Receive the data of a neighbor (the hub forwards them)
+           \return true if all data of the queue are received
+        */
+    inline bool recvNeighbor(unsigned int threadIdQueue, unsigned int threadId, std::vector<T> &dataNotLast, std::vector<T> &dataLast, bool withDataLast, std::size_t limit)
+    {
+        if (threadId != hubThread) return recvQueue(threadIdQueue, threadId, dataNotLast, dataLast, withDataLast, limit);
+        std::size_t nbNotLast = dataNotLast.size(), nbLast = dataLast.size();
+        bool all = recvQueue(threadIdQueue, threadId, dataNotLast, dataLast, withDataLast, limit);
+        relay(threadIdQueue, dataLast, nbLast);
+        relay(threadIdQueue, dataNotLast, nbNotLast);
+        return all;
+    }
+
+    /* Receive at most importBudget data, served round-robin across the neighbors
+        */
+    inline void recvBudget(unsigned int threadId, std::vector<T> &dataNotLast, std::vector<T> &dataLast, bool withDataLast, std::vector<unsigned int> *origins)
+    {
+        const std::vector<unsigned int> &queues = neighbors[threadId];
+        const std::size_t nbQueues = queues.size();
+        if (nbQueues == 0) return;
+        std::vector<char> &active = activeQueues[threadId];
+        active.assign(nbQueues, 1);
+        std::size_t nbActive = nbQueues, budget = importBudget;
+        const std::size_t first = roundRobin[threadId]++ % nbQueues; //The first served changes at each call
+        while (budget && nbActive){
+            //Each round, the remaining budget is shared by the queues that are not empty
+            const std::size_t quantum = std::max<std::size_t>(1, budget / nbActive);
+            for (std::size_t k = 0; k < nbQueues && budget; k++){
+                const std::size_t i = (first + k) % nbQueues;
+                if (!active[i]) continue;
+                const std::size_t nbData = dataNotLast.size() + dataLast.size();
+                if (recvNeighbor(queues[i], threadId, dataNotLast, dataLast, withDataLast, std::min(quantum, budget))){
+                    active[i] = 0;
+                    nbActive--;
+                }
+                const std::size_t nbTaken = dataNotLast.size() + dataLast.size() - nbData;
+                if (origins) origins->resize(origins->size() + nbTaken, queues[i]);
+                budget -= nbTaken;
+            }
+        }
+    }
 
     /* Receive all elements from the communicator.
            \param data: Received elements
@@ -193,67 +1206,37 @@ public:
         */
     inline void recvAll(std::vector<T> &dataNotLast, std::vector<T> &dataLast, bool withDataLast = true)
     {
-        const unsigned int threadId = group.getThreadId();
-        if (!receivers[threadId]) return; //If this thread is not a receiver, do nothing !
-
-        for (unsigned int threadIdQueue = 0; threadIdQueue < nbThreads; threadIdQueue++)
-        {
-            //Browse all queues except the queue of this thread and the queues from threads that are not a sender
-            if (threadIdQueue != threadId && senders[threadIdQueue])
-            {
-
-                //These adresses don't move, so no mutex here !
-                std::deque<T> &deque = vectorOfQueues[threadIdQueue];
-                std::vector<unsigned int> &queuePointer = threadQueuesPointer[threadIdQueue];
-                //Special issue if the watch of thread is at the end or that the vector is empty (no clause to recuperate)
-                if (deque.empty() || queuePointer[threadId] == deque.size())
-                {
-                    continue;
-                }
-
-                std::mutex &mutex = threadMutexs[threadIdQueue];
-                unsigned int &minQueuePointer = minQueuesPointer[threadIdQueue];
-                unsigned int &minSecondQueuePointer = minSecondQueuesPointer[threadIdQueue];
-                std::vector<OrderPointer *> &ordersPointer = threadOrdersPointer[threadIdQueue];
-
-                mutex.lock();
-
-                //Verify the queue of pointers
-                assertQueuePointerCriticalSection(threadIdQueue);
-
-                //Get the minimum and the second minimum !
-                minQueuePointer = queuePointer[threadOrdersPointerStart[threadIdQueue]->next->idThread];
-
-                if (withDataLast){
-                    int idSecondQueuePointer = threadOrdersPointerStart[threadIdQueue]->next->next->idThread;
-                    minSecondQueuePointer = (idSecondQueuePointer == -1) ? deque.size() : queuePointer[idSecondQueuePointer];
-
-                    //Recuperate clauses that I have to no copy : it is the dataLast thread that take these clauses
-                    if (minQueuePointer == queuePointer[threadId])
-                    { //I am a minumum : there are may be dataLast clauses with no copy (this thread is at the smallest position)
-                        while (queuePointer[threadId] != minSecondQueuePointer)
-                        { // warning, that can be equals (severals minimums equals)!
-                            dataLast.push_back(deque[queuePointer[threadId]++]);
-                            nbRecv[threadId]++;
-                        }
-                    }
-                }
-                //Now, recuperate clauses that I have to copy
-                while (queuePointer[threadId] != deque.size())
-                {
-                    dataNotLast.push_back(deque[queuePointer[threadId]++]);
-                    nbRecv[threadId]++;
-                }
-                //At this time, this assertion have to be verify (no more clauses to recuperate)
-                assert(queuePointer[threadId] == deque.size());
-
-                //Update the ordersPointer 
-                updateOrdersPointer(ordersPointer, threadIdQueue, threadId);
+        recvAll(dataNotLast, dataLast, withDataLast, NULL);
+    }
 
-                //pop data already recuperate by all threads
-                if (minQueuePointer > 1000) popDataReceived(minQueuePointer, threadIdQueue, queuePointer, deque);
+    /* Receive all elements, with the thread that has sent each of them (e.g. to call feedback())
+           \param data Received elements
+           \param origins For each received element, the sender
+        */
+    inline void recvAll(std::vector<T> &data, std::vector<unsigned int> &origins)
+    {
+        std::vector<T> noDataLast;
+        recvAll(data, noDataLast, false, &origins);
+    }
 
-                mutex.unlock();
+    inline void recvAll(std::vector<T> &dataNotLast, std::vector<T> &dataLast, bool withDataLast, std::vector<unsigned int> *origins)
+    {
+        const unsigned int threadId = getThreadId();
+        if (!receivers[threadId] || detached[threadId]) return; //If this thread is not a receiver, do nothing !
+        if (lagTimeout.count()) lastReceive[threadId].store(nanoseconds(), std::memory_order_relaxed);
+        if (recorder) recorder->recvAll(threadId);
+
+        //Gossip topology: periodically change the neighbors
+        if (gossipDegree && (nbRecvAll[threadId] + 1) % gossipPeriod == 0) reshuffle(threadId);
+
+        if (importBudget)
+            recvBudget(threadId, dataNotLast, dataLast, withDataLast, origins);
+        else{
+            //Browse the queues of the neighbors of this thread (by default, all queues except the queue of this thread and the queues from threads that are not a sender)
+            for (unsigned int threadIdQueue : neighbors[threadId]){
+                const std::size_t nbData = dataNotLast.size() + dataLast.size();
+                recvNeighbor(threadIdQueue, threadId, dataNotLast, dataLast, withDataLast, SIZE_MAX);
+                if (origins) origins->resize(origins->size() + dataNotLast.size() + dataLast.size() - nbData, threadIdQueue);
             }
         }
         nbRecvAll[threadId]++;
@@ -276,51 +1259,132 @@ public:
         */
     inline bool recv(T &data, bool &isLast)
     {
-        const unsigned int threadId = group.getThreadId();
-        for (unsigned int threadIdQueue = 0; threadIdQueue < nbThreads; threadIdQueue++)
+        const unsigned int threadId = getThreadId();
+        if (!receivers[threadId] || detached[threadId]) return false; //If this thread is not a receiver, do nothing !
+        if (lagTimeout.count()) lastReceive[threadId].store(nanoseconds(), std::memory_order_relaxed);
+        if (recorder) recorder->recv(threadId);
+        //Browse the queues of the neighbors of this thread (all other senders by default)
+        for (unsigned int threadIdQueue : neighbors[threadId])
         {
-            //Browse all queue except the queue of this thread
-            if (threadIdQueue != threadId)
+            
+            unsigned int i = 0;
+            DataQueue &deque = vectorOfQueues[threadIdQueue];
+            std::vector<std::size_t> &queuePointer = threadQueuesPointer[threadIdQueue];
+            std::mutex &mutex = threadMutexs[threadIdQueue];
+            std::size_t &minQueuePointer = minQueuesPointer[threadIdQueue];
+
+            //Special issue if the watch of thread is at the end : no data
+            if (queuePointer[threadId] >= endPosition(threadIdQueue))
             {
-                
-                unsigned int i = 0;
-                std::deque<T> &deque = vectorOfQueues[threadIdQueue];
-                std::vector<unsigned int> &queuePointer = threadQueuesPointer[threadIdQueue];
-                std::mutex &mutex = threadMutexs[threadIdQueue];
-                unsigned int &minQueuePointer = minQueuesPointer[threadIdQueue];
-
-                //Special issue if the watch of thread is at the end or the vector is empty : no data
-                if (deque.empty() || queuePointer[threadId] == deque.size())
-                {
-                    continue;
-                }
+                continue;
+            }
 
-                mutex.lock();
-                
-                //Recuperate the data and increment the queuePointer of the thread
-                unsigned int positionRet = queuePointer[threadId];
-                data = deque[queuePointer[threadId]++];
-
-                //Update the minWatch (usefull to know data to pop)
-                minQueuePointer = INT_MAX;
-                for (; i < nbThreads; i++)
-                    if (i != threadIdQueue && minQueuePointer > queuePointer[i])
-                        minQueuePointer = queuePointer[i];
-                
-                //Find if it is the dataLast or not
-                isLast = (positionRet < minQueuePointer) ? true : false;
-                
-                //pop data already recuperate by all threads
-                if (minQueuePointer > 1000) popDataReceived(minQueuePointer, threadIdQueue, queuePointer, deque);
-                
-                nbRecv[threadId]++;
-                mutex.unlock();
-                return true;
+            lockQueue(threadIdQueue, threadId);
+            if (!isReader(threadIdQueue, threadId)) resume(threadIdQueue, threadId);
+
+            //Skip the data dropped by a full queue
+            skipDropped(threadIdQueue, threadId);
+            const std::size_t base = queuesBase[threadIdQueue];
+            
+            //Recuperate the first data accepted by the filter and increment the queuePointer of the thread
+            const std::size_t end = endPosition(threadIdQueue);
+            const std::size_t start = queuePointer[threadId];
+            std::size_t positionRet = end;
+            while (queuePointer[threadId] != end)
+            {
+                const std::size_t index = queuePointer[threadId]++ - base;
+                if (isEcho(threadIdQueue, threadId, index)) continue;
+                if (withMetrics) sampleLatencies(threadIdQueue, threadId, queuePointer[threadId] - 1, queuePointer[threadId]);
+                if (accept(threadIdQueue, threadId, deque[index])){
+                    positionRet = queuePointer[threadId] - 1;
+                    data = deque[index];
+                    break;
+                }
             }
+
+            //Update the minWatch (usefull to know data to pop)
+            minQueuePointer = endPosition(threadIdQueue);
+            for (; i < threadOrdersPointer[threadIdQueue].size(); i++)
+                if (isReader(threadIdQueue, i) && minQueuePointer > position(threadIdQueue, i))
+                    minQueuePointer = position(threadIdQueue, i);
+            
+            //Find if it is the dataLast or not
+            isLast = (positionRet < minQueuePointer) ? true : false;
+            if (recorder && queuePointer[threadId] != start) recorder->advance(threadId, threadIdQueue, start, queuePointer[threadId]);
+
+            //Keep the ordersPointer sorted (used by recvAll)
+            advanceOrdersPointer(threadOrdersPointer[threadIdQueue], threadIdQueue, threadId);
+            
+            //pop data already recuperate by all threads
+            if (minQueuePointer - base >= reclaimThreshold) popDataReceived(minQueuePointer, threadIdQueue);
+
+            //Wake up a sender blocked on a full queue
+            if (capacity && overflowPolicy == OverflowPolicy::block) threadConditions[threadIdQueue].notify_all();
+            
+            mutex.unlock();
+            if (positionRet == end) continue; //All data of this queue are rejected by the filter
+            if (threadId == hubThread) relay(threadIdQueue, data);
+            return true;
         }
         return false;
     }
 
+    /* Receive only one data, sleep until a data arrives or the timeout expires
+           \param data received
+           \param timeout The maximum waiting time
+           \return false if no element is found before the timeout, true otherwise
+        */
+    inline bool recvWait(T &data, std::chrono::nanoseconds timeout)
+    {
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+        while (true){
+            if (recv(data)) return true;
+            if (!waitData(deadline)) return false;
+        }
+    }
+
+    /* Receive all elements (see recvAll()), sleep until a data arrives or the timeout expires
+           \param data Received elements
+           \param timeout The maximum waiting time
+           \return false if no element is found before the timeout, true otherwise
+        */
+    inline bool recvAllWait(std::vector<T> &data, std::chrono::nanoseconds timeout)
+    {
+        std::vector<T> noDataLast;
+        return recvAllWait(data, noDataLast, timeout, false);
+    }
+
+    inline bool recvAllWait(std::vector<T> &dataNotLast, std::vector<T> &dataLast, std::chrono::nanoseconds timeout, bool withDataLast = true)
+    {
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+        const std::size_t nbData = dataNotLast.size() + dataLast.size();
+        while (true){
+            recvAll(dataNotLast, dataLast, withDataLast);
+            if (dataNotLast.size() + dataLast.size() != nbData) return true;
+            if (!waitData(deadline)) return false;
+        }
+    }
+
+    /* Sleep until a data is sent to the calling thread (or a spurious wakeup)
+           \return false if the deadline is passed or the group is stopped
+        */
+    inline bool waitData(std::chrono::steady_clock::time_point deadline)
+    {
+        const uint32_t key = events.prepareWait();
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now >= deadline || getCurrentGroup().isStopped()){
+            events.cancelWait();
+            return false;
+        }
+        if (!isEmpty()){
+            events.cancelWait();
+            return true;
+        }
+        //Wake up at least every 10ms to see the stop of the group
+        events.wait(key, std::min<std::chrono::nanoseconds>(deadline - now, std::chrono::milliseconds(10)));
+        return true;
+    }
+
     inline unsigned int getNbSend()
     {
         unsigned int ret = 0;
@@ -336,10 +1400,63 @@ public:
     {
         unsigned int ret = 0;
         for (unsigned int threadId = 0; threadId < nbThreads; threadId++)
+            ret += nbRecv[threadId].load(std::memory_order_relaxed);
+        return ret;
+    };
+
+    /* Number of data received (accepted by its filter) by the thread threadId
+    */
+    inline unsigned int getNbRecv(unsigned int threadId)
+    {
+        return nbRecv[threadId].load(std::memory_order_relaxed);
+    };
+
+    /* Number of data rejected by the filter of the thread threadId (see setFilter())
+    */
+    inline unsigned int getNbRejected(unsigned int threadId)
+    {
+        return nbRejected[threadId].load(std::memory_order_relaxed);
+    };
+    inline unsigned int getNbRejected()
+    {
+        unsigned int ret = 0;
+        for (unsigned int threadId = 0; threadId < nbThreads; threadId++)
+            ret += nbRejected[threadId].load(std::memory_order_relaxed);
+        return ret;
+    };
+
+    /* Number of data dropped (see setCapacity()) before the thread threadId received them
+    */
+    inline unsigned int getNbDropped(unsigned int threadId)
+    {
+        unsigned int ret = 0;
+        std::vector<unsigned int> threadNeighbors; //A copy: a gossip topology changes them (see reshuffle())
         {
-            threadMutexs[threadId].lock();
-            ret += nbRecv[threadId];
-            threadMutexs[threadId].unlock();
+            std::lock_guard<std::mutex> lock(threadMutexs[threadId]);
+            threadNeighbors = neighbors[threadId];
+        }
+        for (unsigned int threadIdQueue = 0; threadIdQueue < nbThreads; threadIdQueue++)
+        {
+            threadMutexs[threadIdQueue].lock();
+            ret += threadQueuesDropped[threadIdQueue][threadId];
+            //The reclaimed data not yet skipped by a reader (or by a lagging reader detached from the queue)
+            if (isReader(threadIdQueue, threadId) || (!detached[threadId] && std::find(threadNeighbors.begin(), threadNeighbors.end(), threadIdQueue) != threadNeighbors.end()))
+                ret += position(threadIdQueue, threadId) - threadQueuesPointer[threadIdQueue][threadId];
+            threadMutexs[threadIdQueue].unlock();
+        }
+        return ret;
+    };
+    inline unsigned int getNbDropped()
+    {
+        unsigned int ret = 0;
+        for (unsigned int threadIdQueue = 0; threadIdQueue < nbThreads; threadIdQueue++)
+        {
+            threadMutexs[threadIdQueue].lock();
+            for (unsigned int j = 0; j < threadQueuesDropped[threadIdQueue].size(); j++){
+                ret += threadQueuesDropped[threadIdQueue][j];
+                if (isReader(threadIdQueue, j)) ret += position(threadIdQueue, j) - threadQueuesPointer[threadIdQueue][j];
+            }
+            threadMutexs[threadIdQueue].unlock();
         }
         return ret;
     };
@@ -371,17 +1488,57 @@ Communicator<T>::Communicator(Group& g, const std::vector<bool>& p_senders, cons
 
 
 
+template <class T>
+Communicator<T>::Communicator(Group& g, const Topology& topology, bool withInitialize)
+    : Communicator<T>::Communicator(std::vector<Group*>(1, &g), topology, withInitialize)
+{}
+
+template <class T>
+Communicator<T>::Communicator(const std::vector<Group*>& pgroups, const Topology& topology, bool withInitialize)
+    : Communicator<T>::Communicator(pgroups, false)
+{
+    assert(topology.getNbThreads() == nbThreads);
+    hasTopology = true;
+    for (unsigned int i = 0; i < nbThreads; i++) neighbors[i] = topology.getNeighbors(i);
+    gossipDegree = topology.getGossipDegree();
+    gossipPeriod = topology.getGossipPeriod() ? topology.getGossipPeriod() : 1;
+    hubThread = topology.getHub();
+    for (unsigned int i = 0; i < nbThreads; i++) generators.push_back(std::mt19937(i));
+    if (withInitialize == true) initialize();
+}
+
 template <class T>
 Communicator<T>::Communicator(Group& g, bool withInitialize)
-    : group(g),
-      nbThreads(g.getNbThreads()),
+    : Communicator<T>::Communicator(std::vector<Group*>(1, &g), withInitialize)
+{}
+
+template <class T>
+unsigned int Communicator<T>::countThreads(const std::vector<Group*>& pgroups)
+{
+    unsigned int ret = 0;
+    for (Group* g : pgroups) ret += g->getNbThreads();
+    return ret;
+}
+
+template <class T>
+Communicator<T>::Communicator(const std::vector<Group*>& pgroups, bool withInitialize)
+    : group(pgroups[0]),
+      nbThreads(countThreads(pgroups)),
+      groups(pgroups.size() > 1 ? pgroups : std::vector<Group*>()),
       
       senders(std::vector<bool>(nbThreads, true)),
       receivers(std::vector<bool>(nbThreads, true)),
+      neighbors(nbThreads),
+      hasTopology(false),
+      gossipDegree(0),
+      gossipPeriod(0),
+      hubThread(UINT_MAX),
       
       vectorOfQueues(nbThreads),
       threadMutexs(nbThreads),
-      threadQueuesPointer(nbThreads, std::vector<unsigned int>(nbThreads)),
+      queuesNbReaders(nbThreads, 0),
+      threadQueuesPointer(nbThreads, std::vector<std::size_t>(nbThreads, 0)),
+      queuesBase(nbThreads, 0),
       threadOrdersPointer(nbThreads, std::vector<OrderPointer *>(nbThreads, NULL)),
       threadOrdersPointerStart(nbThreads, NULL),
       threadOrdersPointerEnd(nbThreads, NULL),
@@ -389,10 +1546,45 @@ Communicator<T>::Communicator(Group& g, bool withInitialize)
       minQueuesPointer(nbThreads),
       minSecondQueuesPointer(nbThreads),
 
+      reclaimThreshold(1000),
+      capacity(0),
+      overflowPolicy(OverflowPolicy::dropOldest),
+      threadConditions(nbThreads),
+      threadQueuesDropped(nbThreads, std::vector<unsigned int>(nbThreads, 0)),
+
+      filters(nbThreads),
+
       nbSend(nbThreads),
       nbRecv(nbThreads),
-      nbRecvAll(nbThreads)
+      nbRecvAll(nbThreads),
+      nbRejected(nbThreads),
+      withMetrics(false),
+      samplingPeriod(0),
+      detached(nbThreads),
+      lagTimeout(0),
+      lastReceive(nbThreads),
+      importBudget(0),
+      roundRobin(nbThreads, 0),
+      activeQueues(nbThreads),
+      withExportControl(false),
+      targetUsefulness(0),
+      minExportRate(0),
+      exportRates(nbThreads),
+      exportCredits(nbThreads, 0),
+      nbImported(nbThreads),
+      nbUseful(nbThreads),
+      nbThrottled(nbThreads, 0),
+      recorder(NULL)
 {
+    for (unsigned int i = 0; i < nbThreads; i++){
+        detached[i] = false;
+        nbRecv[i] = nbRejected[i] = 0;
+        lastReceive[i] = 0;
+        exportRates[i] = 1;
+        nbImported[i] = nbUseful[i] = 0;
+    }
+    for (unsigned int i = 0, offset = 0; i < groups.size(); offset += groups[i]->getNbThreads(), i++)
+        groupOffsets.push_back(offset);
     if (withInitialize == true) initialize();
 }
 
@@ -405,6 +1597,18 @@ void Communicator<T>::removePointer(unsigned int queue, unsigned int thread){
     threadOrdersPointer[queue][thread] = NULL;
 }
 
+/* To add a pointer at the end of the double linked list (the thread receives only the next data) */
+template <class T>
+void Communicator<T>::addPointer(unsigned int queue, unsigned int thread){
+    OrderPointer *pointer = new OrderPointer(thread);
+    pointer->next = threadOrdersPointerEnd[queue];
+    pointer->previous = threadOrdersPointerEnd[queue]->previous;
+    threadOrdersPointerEnd[queue]->previous->next = pointer;
+    threadOrdersPointerEnd[queue]->previous = pointer;
+    threadOrdersPointer[queue][thread] = pointer;
+    threadQueuesPointer[queue][thread] = endPosition(queue);
+}
+
 /* To initialize the double linked list OrderPointer */
 template <class T>
 void Communicator<T>::createOrderPointer(unsigned int queue, unsigned int lenght){
@@ -429,6 +1633,17 @@ void Communicator<T>::createOrderPointer(unsigned int queue, unsigned int lenght
 
 template <class T>
 void Communicator<T>::initialize(){
+    //The queues read by each receiver: its neighbors (all other threads without Topology) that are senders
+    for (unsigned int j = 0; j < nbThreads; j++)
+    {
+        std::vector<unsigned int> queues;
+        if (receivers[j]){
+            for (unsigned int i = 0; i < nbThreads; i++)
+                if (i != j && senders[i] && (!hasTopology || std::find(neighbors[j].begin(), neighbors[j].end(), i) != neighbors[j].end()))
+                    queues.push_back(i);
+        }
+        neighbors[j] = queues;
+    }
     for (unsigned int i = 0; i < nbThreads; i++)
     {
         if (senders[i]){ //Only if i is a sender thread !
@@ -438,11 +1653,13 @@ void Communicator<T>::initialize(){
             //The ith queue do not need a pointer of itself
             removePointer(i, i);
 
-            //Delete the non-receivers pointer
+            //Delete the non-receivers pointer (and the threads that are not a neighbor of i)
             for (unsigned int j = 0; j < nbThreads; j++){
-                if (!receivers[j] && j != i){
+                if (j == i) continue;
+                if (std::find(neighbors[j].begin(), neighbors[j].end(), i) == neighbors[j].end())
                     removePointer(i, j);
-                }
+                else
+                    queuesNbReaders[i]++;
             }
         }
     }
@@ -463,6 +1680,7 @@ void Communicator<T>::deleteOrderPointer(){
 template <class T>
 Communicator<T>::~Communicator()
 {
+    for (std::pair<Group*, unsigned int> &listener : taskListeners) listener.first->removeTaskListener(listener.second);
     deleteOrderPointer();
 }
 } // namespace pFactory
@@ -0,0 +1,431 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef concurrentqueues_H
+#define concurrentqueues_H
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Eventcounts.h"
+
+namespace pFactory
+{
+
+/*
+ * Queues to pass data from some threads to others (work pipelines), where a Communicator broadcasts to all threads:
+ *  - BoundedQueue: any number of producers and consumers, a fixed capacity (an array of cells with sequence numbers);
+ *  - MpscQueue: any number of producers and one consumer, unbounded (a list of segments);
+ *  - SpscQueue: one producer and one consumer, a fixed capacity (a ring).
+ * try_push() and try_pop() never wait. With waitable set at the construction, push() and pop() spin for a bounded time
+ * then sleep until a consumer (resp. producer) makes room (resp. pushes): a successful try_push() or try_pop() then
+ * costs a fence more to wake up the sleeping threads, so a queue only used with try_push()/try_pop() is not waitable.
+ */
+
+/* The number of checks before sleeping in push() and pop() (0 on a single core)
+*/
+inline unsigned int queueSpins() {return std::thread::hardware_concurrency() > 1 ? 4096 : 0;}
+
+/* Retry an operation until it succeeds: spin for a bounded time, yield the core a few times (the other side may be
+   on it), then sleep on an EventCount notified on each change
+*/
+template <class Operation>
+inline void retryOrSleep(EventCount& changed, unsigned int nbSpins, Operation operation)
+{
+    for (unsigned int i = 0; i < nbSpins; i++){
+        if (operation()) return;
+        cpuRelax();
+    }
+    for (unsigned int i = 0; i < 16; i++){
+        if (operation()) return;
+        std::this_thread::yield();
+    }
+    while (!operation()){
+        const uint32_t key = changed.prepareWait();
+        if (operation()){
+            changed.cancelWait();
+            return;
+        }
+        changed.wait(key, std::chrono::milliseconds(100));
+    }
+}
+
+/* The smallest power of two greater than or equal to n (and 2)
+*/
+inline std::size_t queueCapacity(std::size_t n)
+{
+    std::size_t capacity = 2;
+    while (capacity < n) capacity <<= 1;
+    return capacity;
+}
+
+/*
+ * A bounded queue for any number of producers and consumers (Dmitry Vyukov's algorithm): each cell has a sequence
+ * number that says if it is free for the push of a position or full for the pop of a position. A push (resp. pop) takes
+ * a position with a CAS on the tail (resp. head) only: no lock and no allocation.
+ * The data are in FIFO order. The capacity is rounded up to a power of two.
+ */
+template <class T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(std::size_t pcapacity, bool pwaitable = false)
+        : capacity(queueCapacity(pcapacity)),
+          mask(capacity - 1),
+          cells(capacity),
+          waitable(pwaitable),
+          nbSpins(queueSpins()),
+          tail(0),
+          head(0)
+    {
+        for (std::size_t i = 0; i < capacity; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    ~BoundedQueue()
+    {
+        T value;
+        while (try_pop(value));
+    }
+
+    /* \return false if the queue is full
+    */
+    template <class U>
+    inline bool try_push(U&& value)
+    {
+        std::size_t position = tail.load(std::memory_order_relaxed);
+        while (true){
+            Cell& cell = cells[position & mask];
+            const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+            if (difference == 0){ //Free for this position
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    new (&cell.storage) T(std::forward<U>(value));
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    if (waitable) pushed.notifyAll();
+                    return true;
+                }
+            }else if (difference < 0) return false; //Not yet popped one lap ago: full
+            else position = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    /* \return false if the queue is empty
+    */
+    inline bool try_pop(T& value)
+    {
+        std::size_t position = head.load(std::memory_order_relaxed);
+        while (true){
+            Cell& cell = cells[position & mask];
+            const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+            if (difference == 0){ //Full for this position
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    T* data = reinterpret_cast<T*>(&cell.storage);
+                    value = std::move(*data);
+                    data->~T();
+                    cell.sequence.store(position + capacity, std::memory_order_release);
+                    if (waitable) popped.notifyAll();
+                    return true;
+                }
+            }else if (difference < 0) return false; //Not yet pushed: empty
+            else position = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    /* Wait while the queue is full (the queue has to be waitable)
+    */
+    template <class U>
+    inline void push(U&& value)
+    {
+        assert(waitable);
+        retryOrSleep(popped, nbSpins, [&]{return try_push(std::forward<U>(value));});
+    }
+
+    /* Wait while the queue is empty (the queue has to be waitable)
+    */
+    inline void pop(T& value)
+    {
+        assert(waitable);
+        retryOrSleep(pushed, nbSpins, [&]{return try_pop(value);});
+    }
+
+    /* Approximate while other threads push or pop */
+    inline bool empty() const {return size() == 0;}
+    inline std::size_t size() const
+    {
+        const std::size_t h = head.load(std::memory_order_acquire);
+        const std::size_t t = tail.load(std::memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+    inline std::size_t getCapacity() const {return capacity;}
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    const std::size_t capacity;
+    const std::size_t mask;
+    std::vector<Cell> cells;
+    const bool waitable;
+    const unsigned int nbSpins;
+    EventCount pushed;
+    EventCount popped;
+    alignas(64) std::atomic<std::size_t> tail; /* The producers and the consumers on their own cache lines */
+    alignas(64) std::atomic<std::size_t> head;
+};
+
+/*
+ * An unbounded queue for any number of producers and one consumer: a list of segments of segmentSize cells.
+ * A producer takes a position with a CAS on the tail (the position in the segment and the number of the segment).
+ * The producer of the last cell of a segment links a new segment, the others wait for it for the time of an allocation.
+ * A producer only uses a segment once it has a cell in it, so the consumer deletes a segment as soon as it has popped
+ * all its cells. The data of a producer are in FIFO order.
+ */
+template <class T, std::size_t segmentSize = 1024>
+class MpscQueue
+{
+public:
+    explicit MpscQueue(bool pwaitable = false)
+        : waitable(pwaitable),
+          nbSpins(queueSpins()),
+          tail(0),
+          tailSegment(new Segment()),
+          headSegment(tailSegment.load(std::memory_order_relaxed)),
+          headOffset(0)
+    {
+        static_assert((segmentSize & (segmentSize - 1)) == 0, "The size of a segment has to be a power of two");
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    ~MpscQueue()
+    {
+        T value;
+        while (try_pop(value));
+        delete headSegment;
+    }
+
+    /* Never fails (the queue is unbounded)
+    */
+    template <class U>
+    inline bool try_push(U&& value)
+    {
+        uint64_t position = tail.load(std::memory_order_acquire);
+        while (true){
+            const std::size_t offset = position & offsetMask;
+            if (offset == segmentSize){ //Another producer links the next segment
+                cpuRelax();
+                position = tail.load(std::memory_order_acquire);
+                continue;
+            }
+            Segment* segment = tailSegment.load(std::memory_order_acquire);
+            if (!tail.compare_exchange_weak(position, position + 1, std::memory_order_acq_rel, std::memory_order_acquire)) continue;
+            //The cell is taken: the segment is the tail segment until the next one is linked by this producer
+            if (offset == segmentSize - 1){
+                Segment* next = new Segment();
+                tailSegment.store(next, std::memory_order_release);
+                tail.store((position | offsetMask) + 1, std::memory_order_release);
+                segment->next.store(next, std::memory_order_release);
+            }
+            Cell& cell = segment->cells[offset];
+            new (&cell.storage) T(std::forward<U>(value));
+            cell.full.store(true, std::memory_order_release);
+            if (waitable) pushed.notifyAll();
+            return true;
+        }
+    }
+
+    template <class U>
+    inline void push(U&& value) {try_push(std::forward<U>(value));}
+
+    /* Only called by the consumer
+       \return false if the queue is empty
+    */
+    inline bool try_pop(T& value)
+    {
+        Cell& cell = headSegment->cells[headOffset];
+        if (!cell.full.load(std::memory_order_acquire)) return false;
+        T* data = reinterpret_cast<T*>(&cell.storage);
+        value = std::move(*data);
+        data->~T();
+        if (++headOffset == segmentSize){ //The next segment is linked before the last cell is full
+            Segment* next = headSegment->next.load(std::memory_order_acquire);
+            delete headSegment;
+            headSegment = next;
+            headOffset = 0;
+        }
+        return true;
+    }
+
+    /* Wait while the queue is empty (the queue has to be waitable, only called by the consumer)
+    */
+    inline void pop(T& value)
+    {
+        assert(waitable);
+        retryOrSleep(pushed, nbSpins, [&]{return try_pop(value);});
+    }
+
+    /* Only called by the consumer */
+    inline bool empty() const {return !headSegment->cells[headOffset].full.load(std::memory_order_acquire);}
+
+private:
+    /* The position in a segment: segmentSize means that the next segment is being linked */
+    static const uint64_t offsetMask = (uint64_t)segmentSize * 2 - 1;
+
+    struct Cell
+    {
+        std::atomic<bool> full;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        Cell() : full(false) {}
+    };
+
+    struct Segment
+    {
+        std::atomic<Segment*> next;
+        Cell cells[segmentSize];
+        Segment() : next(NULL) {}
+    };
+
+    const bool waitable;
+    const unsigned int nbSpins;
+    EventCount pushed;
+    alignas(64) std::atomic<uint64_t> tail; /* The producers and the consumer on their own cache lines */
+    std::atomic<Segment*> tailSegment;
+    alignas(64) Segment* headSegment;
+    std::size_t headOffset;
+};
+
+/*
+ * A bounded queue for one producer and one consumer: a ring where the producer only writes the tail and the consumer
+ * only writes the head. Each one keeps the last index of the other that it has read, so it only reads the cache line
+ * of the other when the ring looks full (resp. empty). The capacity is rounded up to a power of two.
+ */
+template <class T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(std::size_t pcapacity, bool pwaitable = false)
+        : capacity(queueCapacity(pcapacity)),
+          mask(capacity - 1),
+          cells(capacity),
+          waitable(pwaitable),
+          nbSpins(queueSpins()),
+          tail(0),
+          cachedHead(0),
+          head(0),
+          cachedTail(0)
+    {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    ~SpscQueue()
+    {
+        T value;
+        while (try_pop(value));
+    }
+
+    /* Only called by the producer
+       \return false if the queue is full
+    */
+    template <class U>
+    inline bool try_push(U&& value)
+    {
+        const std::size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead == capacity){
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead == capacity) return false;
+        }
+        new (&cells[position & mask]) T(std::forward<U>(value));
+        tail.store(position + 1, std::memory_order_release);
+        if (waitable) pushed.notifyAll();
+        return true;
+    }
+
+    /* Only called by the consumer
+       \return false if the queue is empty
+    */
+    inline bool try_pop(T& value)
+    {
+        const std::size_t position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail){
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail) return false;
+        }
+        T* data = reinterpret_cast<T*>(&cells[position & mask]);
+        value = std::move(*data);
+        data->~T();
+        head.store(position + 1, std::memory_order_release);
+        if (waitable) popped.notifyAll();
+        return true;
+    }
+
+    /* Wait while the queue is full (the queue has to be waitable)
+    */
+    template <class U>
+    inline void push(U&& value)
+    {
+        assert(waitable);
+        retryOrSleep(popped, nbSpins, [&]{return try_push(std::forward<U>(value));});
+    }
+
+    /* Wait while the queue is empty (the queue has to be waitable)
+    */
+    inline void pop(T& value)
+    {
+        assert(waitable);
+        retryOrSleep(pushed, nbSpins, [&]{return try_pop(value);});
+    }
+
+    /* Approximate while the other thread pushes or pops */
+    inline bool empty() const {return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);}
+    inline std::size_t getCapacity() const {return capacity;}
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+    const std::size_t capacity;
+    const std::size_t mask;
+    std::vector<Storage> cells;
+    const bool waitable;
+    const unsigned int nbSpins;
+    EventCount pushed;
+    EventCount popped;
+    alignas(64) std::atomic<std::size_t> tail; /* The producer and the consumer on their own cache lines */
+    std::size_t cachedHead;
+    alignas(64) std::atomic<std::size_t> head;
+    std::size_t cachedTail;
+};
+
+} // namespace pFactory
+
+#endif
@@ -0,0 +1,254 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef deterministiccommunicators_H
+#define deterministiccommunicators_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "Groups.h"
+#include "Eventcounts.h"
+
+namespace pFactory
+{
+
+/*
+ * A communicator whose receptions do not depend on the timing of the threads (reproducible parallel runs).
+ * The computation of each thread is cut into rounds of unitsPerRound work units (see work()): the data sent by a
+ * thread during its round r are received by all other threads at the end of their round r+1, sender after sender in
+ * the order of the thread ids (and in the order of sending for a sender). If the tasks are deterministic, a run gives
+ * the same receptions whatever the number of cores and the load of the machine.
+ * The end of a round does not wait for the other threads to end the same round: a thread publishes its round and reads
+ * the previous round of the others, so it only waits for the threads that are more than one round late.
+ * A thread whose task ends leaves the rounds (the data of its last round are received, it is no longer waited).
+ * Warning: one task per thread of the group, all threads of the group take part in the rounds
+ */
+template <class T>
+class DeterministicCommunicator
+{
+public:
+    /* \param g Group of threads
+       \param punitsPerRound The number of work units of a round (see work())
+    */
+    DeterministicCommunicator(Group& g, unsigned int punitsPerRound);
+
+    DeterministicCommunicator(const DeterministicCommunicator&) = delete;
+    DeterministicCommunicator& operator=(const DeterministicCommunicator&) = delete;
+
+    ~DeterministicCommunicator() {group.removeTaskListener(listenerId);}
+
+    /* Send a data: it is received by the other threads at the end of their next round
+       \param data Data to send
+    */
+    inline void send(const T& data)
+    {
+        const unsigned int threadId = group.getThreadId();
+        Local& local = locals[threadId];
+        if (local.left) return;
+        queues[threadId].slots[local.round % nbSlots].data.push_back(data);
+        local.nbSend++;
+    }
+
+    /* Count the work units done by this thread, end the round when unitsPerRound units are reached
+       \param units The number of units done since the last call
+       \return true if a round has ended (new data can be received)
+    */
+    inline bool work(unsigned int units = 1)
+    {
+        const unsigned int threadId = group.getThreadId();
+        Local& local = locals[threadId];
+        if (local.left) return false;
+        local.units += units;
+        if (local.units < unitsPerRound) return false;
+        while (local.units >= unitsPerRound){
+            local.units -= unitsPerRound;
+            endRound(threadId);
+        }
+        return true;
+    }
+
+    /* End the round of this thread now (whatever the number of work units done)
+    */
+    inline void endRound()
+    {
+        const unsigned int threadId = group.getThreadId();
+        if (locals[threadId].left) return;
+        locals[threadId].units = 0;
+        endRound(threadId);
+    }
+
+    /* Receive the data of the rounds ended since the last call (added at the end of data)
+       \param data The received data, in the order of the rounds, then of the senders, then of the sendings
+    */
+    inline void recvAll(std::vector<T>& data)
+    {
+        Local& local = locals[group.getThreadId()];
+        if (data.empty()) data.swap(local.received);
+        else data.insert(data.end(), local.received.begin(), local.received.end());
+        local.received.clear();
+    }
+
+    /* Leave the rounds (called at the end of the task of a thread): the data sent during the current round are
+       received by the others, the next sendings are ignored and the others no longer wait for this thread
+    */
+    inline void leave(){leave(group.getThreadId());}
+
+    /* The current round of the calling thread */
+    inline uint64_t getRound() {return locals[group.getThreadId()].round;}
+
+    inline unsigned int getUnitsPerRound() const {return unitsPerRound;}
+
+    /* Warning: the counters of a thread are exact once its task is ended */
+    inline uint64_t getNbSend() const {uint64_t ret = 0; for (const Local& local : locals) ret += local.nbSend; return ret;}
+    inline uint64_t getNbRecv() const {uint64_t ret = 0; for (const Local& local : locals) ret += local.nbRecv; return ret;}
+    inline uint64_t getNbRounds() const {uint64_t ret = 0; for (const Local& local : locals) ret += local.round; return ret;}
+
+    /* The number of ends of round that had to wait for a late thread (the other ones did not block) */
+    inline uint64_t getNbWaits() const {uint64_t ret = 0; for (const Local& local : locals) ret += local.nbWaits; return ret;}
+
+private:
+    /* A thread is at most one round ahead of the others (see endRound()): while it writes its round r, the others can
+       read its rounds r-1, r-2 (after publishing r-1) or r-3 (after publishing r-2), hence four rounds per sender
+    */
+    static const unsigned int nbSlots = 4;
+    static const unsigned int nbSpins = 1024; /* Spins before sleeping on a late thread */
+    static const uint64_t leftRounds = UINT64_MAX; /* The number of published rounds of a thread that has left */
+
+    struct Slot
+    {
+        uint64_t round;     /* The round of the data (published with nbRounds) */
+        std::vector<T> data;
+    };
+
+    /* The rounds of a sender, aligned on a cache line: the others only read nbRounds at the end of their rounds
+    */
+    struct alignas(64) Queue
+    {
+        std::atomic<uint64_t> nbRounds; /* The number of published rounds */
+        Slot slots[nbSlots];
+    };
+
+    /* The state of a thread, only used by this thread
+    */
+    struct alignas(64) Local
+    {
+        uint64_t round;
+        unsigned int units;
+        bool left;
+        std::vector<T> received;
+        uint64_t nbSend;
+        uint64_t nbRecv;
+        uint64_t nbWaits;
+    };
+
+    Group& group;
+    const unsigned int nbThreads;
+    const unsigned int unitsPerRound;
+    unsigned int listenerId;
+    std::vector<Queue> queues;
+    std::vector<Local> locals;
+    EventCount published; /* To sleep on a late thread */
+
+    /* Publish the current round of a thread, receive the previous round of the others and start the next round
+    */
+    inline void endRound(unsigned int threadId)
+    {
+        Local& local = locals[threadId];
+        const uint64_t round = local.round;
+        Queue& queue = queues[threadId];
+        queue.slots[round % nbSlots].round = round;
+        queue.nbRounds.store(round + 1, std::memory_order_release);
+        published.notifyAll();
+
+        if (round > 0){
+            //The senders of the previous round, in the order of the thread ids
+            const uint64_t previous = round - 1;
+            for (unsigned int sender = 0; sender < nbThreads; sender++){
+                if (sender == threadId) continue;
+                waitRound(sender, round, local);
+                const Slot& slot = queues[sender].slots[previous % nbSlots];
+                if (slot.round != previous) continue; //The sender has left before this round
+                local.received.insert(local.received.end(), slot.data.begin(), slot.data.end());
+                local.nbRecv += slot.data.size();
+            }
+        }
+        //The slot of the next round has been read by all threads (they have all published the previous round)
+        local.round = round + 1;
+        queue.slots[local.round % nbSlots].data.clear();
+    }
+
+    /* Wait until a sender has published nbRounds rounds (or has left)
+    */
+    inline void waitRound(unsigned int sender, uint64_t nbRounds, Local& local)
+    {
+        const std::atomic<uint64_t>& senderRounds = queues[sender].nbRounds;
+        if (senderRounds.load(std::memory_order_acquire) >= nbRounds) return; //The usual case: no wait
+        local.nbWaits++;
+        for (unsigned int i = 0; i < nbSpins; i++){
+            std::this_thread::yield();
+            if (senderRounds.load(std::memory_order_acquire) >= nbRounds) return;
+        }
+        while (true){
+            const uint32_t key = published.prepareWait();
+            if (senderRounds.load(std::memory_order_acquire) >= nbRounds){
+                published.cancelWait();
+                return;
+            }
+            published.wait(key, std::chrono::milliseconds(1));
+        }
+    }
+
+    inline void leave(unsigned int threadId)
+    {
+        Local& local = locals[threadId];
+        if (local.left) return;
+        local.left = true;
+        Queue& queue = queues[threadId];
+        queue.slots[local.round % nbSlots].round = local.round;
+        queue.nbRounds.store(leftRounds, std::memory_order_release);
+        published.notifyAll();
+    }
+};
+
+template <class T>
+DeterministicCommunicator<T>::DeterministicCommunicator(Group& g, unsigned int punitsPerRound)
+    : group(g),
+      nbThreads(g.getNbThreads()),
+      unitsPerRound(punitsPerRound ? punitsPerRound : 1),
+      queues(nbThreads),
+      locals(nbThreads)
+{
+    for (unsigned int i = 0; i < nbThreads; i++){
+        queues[i].nbRounds = 0;
+        for (Slot& slot : queues[i].slots) slot.round = leftRounds;
+        locals[i].round = 0;
+        locals[i].units = 0;
+        locals[i].left = false;
+        locals[i].nbSend = 0;
+        locals[i].nbRecv = 0;
+        locals[i].nbWaits = 0;
+    }
+    listenerId = group.addTaskListener(nullptr, [this](unsigned int threadId){leave(threadId);});
+}
+
+} // namespace pFactory
+
+#endif
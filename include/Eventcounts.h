@@ -0,0 +1,121 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef eventcounts_H
+#define eventcounts_H
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace pFactory
+{
+
+/* To spin on a condition before sleeping on an EventCount: a pause of the core between two checks
+*/
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/*
+ * An eventcount: a thread waits for a condition without spinning and without lock on the notifier side.
+ * A waiter calls prepareWait(), checks its condition again, then calls wait(key) (or cancelWait() if the condition holds).
+ * A notifier changes the state then calls notifyAll(): it costs only an atomic load when nobody waits.
+ * On Linux the waiters sleep on a futex, elsewhere on a condition variable.
+ */
+class EventCount
+{
+private:
+    std::atomic<uint32_t> epoch;
+    std::atomic<uint32_t> nbWaiters;
+#ifndef __linux__
+    std::mutex mutex;
+    std::condition_variable condition;
+#endif
+
+public:
+    EventCount() : epoch(0), nbWaiters(0) {}
+    EventCount(const EventCount&) = delete;
+    EventCount& operator=(const EventCount&) = delete;
+
+    /* Announce a wait
+       \return the key to give to wait()
+    */
+    inline uint32_t prepareWait()
+    {
+        nbWaiters.fetch_add(1, std::memory_order_seq_cst);
+        return epoch.load(std::memory_order_seq_cst);
+    }
+
+    /* The condition holds after prepareWait(): do not wait
+    */
+    inline void cancelWait() {nbWaiters.fetch_sub(1, std::memory_order_seq_cst);}
+
+    /* Sleep until a notifyAll() posterior to prepareWait() or the timeout
+       Remark: can return sooner (spurious wakeup), the caller has to check its condition again
+    */
+    inline void wait(uint32_t key, std::chrono::nanoseconds timeout)
+    {
+        if (timeout.count() > 0 && epoch.load(std::memory_order_acquire) == key){
+#ifdef __linux__
+            struct timespec ts;
+            ts.tv_sec = (time_t)(timeout.count() / 1000000000);
+            ts.tv_nsec = (long)(timeout.count() % 1000000000);
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch), FUTEX_WAIT_PRIVATE, key, &ts, NULL, 0);
+#else
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait_for(lock, timeout, [&]{return epoch.load(std::memory_order_acquire) != key;});
+#endif
+        }
+        nbWaiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    /* Wake up all waiting threads (the state has to be changed before)
+    */
+    inline void notifyAll()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (nbWaiters.load(std::memory_order_relaxed) == 0) return; //Nobody sleeps: nothing to do
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+        std::lock_guard<std::mutex> lock(mutex);
+        condition.notify_all();
+#endif
+    }
+
+    inline bool hasWaiters() const {return nbWaiters.load(std::memory_order_relaxed) != 0;}
+};
+
+} // namespace pFactory
+
+#endif
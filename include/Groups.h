@@ -41,6 +41,7 @@
 #include <stdarg.h> 
 
 #include "Barrier.h"
+#include "Collectives.h"
 #include "Task.h"
 
 
@@ -83,7 +84,7 @@ namespace pFactory {
                 wait(); //Join all threads
             }
             delete startedBarrier;
-            delete waitingThreads;
+            stopWaitingThread();
             for(unsigned int i = 0; i < nbThreads; i++)
                 delete threads[i];
         }
@@ -145,6 +146,10 @@ namespace pFactory {
             assert(false); // Impossible
             return threadId;
         }
+        /* The group of the calling thread (NULL if the calling thread is not a thread of a group)
+         */
+        static inline Group* getCurrentGroup() {return currentGroup();}
+
         inline unsigned int getId() const {return idGroup;}
         
         inline unsigned int getNbThreads() const {return nbThreads;}
@@ -178,20 +183,118 @@ namespace pFactory {
             return *this;
         }
 
+        /* Bind each thread to the cores of its NUMA node (see getNumaNode())
+        */
+        Group& bindNumaNodes();
+
+        /* Set the NUMA node of each thread (by default, blocks of consecutive threads are spread on the NUMA nodes of the machine)
+        \param pthreadNumaNodes The NUMA node of each thread
+        */
+        Group& setNumaNodes(const std::vector<unsigned int>& pthreadNumaNodes);
+
+        inline unsigned int getNumaNode(unsigned int threadId) const {return threadNumaNodes[threadId];}
+        inline unsigned int getNbNumaNodes() const {return nbNumaNodes;}
+
+        /* Functions called by a thread of this group with its thread id: onStart before each task, 
+        onEnd after each task and when the thread leaves the group (no more task or stopped group)
+        \return An identifier for removeTaskListener()
+        Warning: has to be called before start()
+        */
+        unsigned int addTaskListener(const std::function<void(unsigned int)>& onStart, const std::function<void(unsigned int)>& onEnd);
+        void removeTaskListener(unsigned int listenerId);
+
+        /* Collective operations between the threads of the group, through a tree of threads (see Collectives): 
+        all threads of the group call the same operations in the same order (as barrier.wait()).
+        The type of the values is trivially copyable, of at most Collectives::maxBytes bytes (no allocation)
+        and op(a, b) is an associative operator (the values are combined in the order of the threads)
+        */
+
+        /* Combine the values of all threads
+        \return The combination of the values of the threads 0, 1, ..., N-1
+        */
+        template <class T, class Op>
+        inline T allreduce(const T& value, Op op) {
+            CollectiveRequest<T, ReduceCombine<T, Op>> request = iallreduce(value, op);
+            request.wait();
+            return request.get();
+        }
+
+        /* Combine the values of all threads for one of them
+        \return The combination for the thread root, value for the others
+        */
+        template <class T, class Op>
+        inline T reduce(const T& value, Op op, unsigned int root = 0) {
+            CollectiveRequest<T, ReduceCombine<T, Op>> request = iallreduce(value, op);
+            request.wait();
+            return getThreadId() == root ? request.get() : value;
+        }
+
+        /* Give the value of each thread to all threads
+        \param values The value of the thread i is copied in values[i] (values has N elements)
+        */
+        template <class T>
+        inline void allgather(const T& value, T* values) {
+            CollectiveRequest<T, GatherCombine<T>> request = iallgather(value, values);
+            request.wait();
+        }
+        template <class T>
+        inline void allgather(const T& value, std::vector<T>& values) {
+            values.resize(nbThreads);
+            allgather(value, values.data());
+        }
+
+        /* Give the value of the thread root to all threads
+        \param value The value to give (only read for the thread root)
+        */
+        template <class T>
+        inline T broadcast(const T& value, unsigned int root = 0) {
+            CollectiveRequest<Broadcasted<T>, BroadcastCombine<T>> request = ibroadcast(value, root);
+            request.wait();
+            return request.get().value;
+        }
+
+        /* The non-blocking versions: test() on the request progresses without waiting and returns true when the
+        operation is finished, get() gives its result (request.get().value for a broadcast, iallreduce() for a reduce)
+        */
+        template <class T, class Op>
+        inline CollectiveRequest<T, ReduceCombine<T, Op>> iallreduce(const T& value, Op op) {
+            return CollectiveRequest<T, ReduceCombine<T, Op>>(collectives, getThreadId(), value, ReduceCombine<T, Op>{op});
+        }
+        template <class T>
+        inline CollectiveRequest<T, GatherCombine<T>> iallgather(const T& value, T* values) {
+            return CollectiveRequest<T, GatherCombine<T>>(collectives, getThreadId(), value, GatherCombine<T>(), values);
+        }
+        template <class T>
+        inline CollectiveRequest<Broadcasted<T>, BroadcastCombine<T>> ibroadcast(const T& value, unsigned int root = 0) {
+            const Broadcasted<T> broadcasted = {value, getThreadId() == root};
+            return CollectiveRequest<Broadcasted<T>, BroadcastCombine<T>>(collectives, getThreadId(), broadcasted, BroadcastCombine<T>());
+        }
+
         inline Controller* getController(){return controller;}
         inline void setController(Controller* _controller){controller = _controller;}
         inline void setConcurrentGroupsModes(bool _concurrentGroupsModes){concurrentGroupsModes=_concurrentGroupsModes;}
     private:
 
+        static inline Group*& currentGroup() {
+            thread_local static Group* group = NULL;
+            return group;
+        }
+
         inline unsigned int getTaskId() {return CurrentTaskIdPerThread[getThreadId()];}
         inline void setTaskStatus(Status _status){tasks[getTaskId()].setStatus(_status);}
         
 
         void wrapperFunction();
+        void notifyTaskListeners(bool start);
 
         void wrapperWaitting(unsigned int seconds);
+        /* Wake up, join and delete the thread of waitAndKill() (if any) before its timeout */
+        void stopWaitingThread();
         // Winner of the concurrential method    
         unsigned int winnerId;
+
+        // Functions called at the start and the end of the tasks (see addTaskListener())
+        std::vector<std::pair<std::function<void(unsigned int)>, std::function<void(unsigned int)>>> taskListeners;
         
         //General variables for a group
         std::vector<std::thread*> threads;
@@ -216,6 +319,9 @@ namespace pFactory {
 
         //For wait with seconds
         std::thread *waitingThreads;
+        std::mutex waitingMutex;
+        std::condition_variable waitingCondition;
+        bool waitingCancelled;
 
         bool hasStarted;
         bool hasWaited;
@@ -225,6 +331,13 @@ namespace pFactory {
         bool taskPopFront;
         Controller* controller;
 
+        //For the NUMA nodes
+        std::vector<unsigned int> threadNumaNodes;
+        unsigned int nbNumaNodes;
+
+        //For the collective operations
+        Collectives collectives;
+
     };
 
     
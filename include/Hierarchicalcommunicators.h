@@ -0,0 +1,155 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef hierarchicalcommunicators_H
+#define hierarchicalcommunicators_H
+
+#include "Communicators.h"
+
+namespace pFactory
+{
+
+/*
+ * A two-level communicator that follows the NUMA nodes of a group (see Group::getNumaNode()).
+ * Threads share their data freely with the threads of their NUMA node (first level).
+ * The first thread of each NUMA node is its representative: when it calls recvAll(), it forwards to the other
+ * representatives a batch of the data of its node (second level), and it redistributes in its node the batches of the others.
+ * Thus a data crosses the interconnect once per other NUMA node: the inter-node traffic is O(nodes²) instead of O(threads²).
+ * Warning: the data of a NUMA node reach the others only when its representative calls recvAll().
+ */
+template <class T>
+class HierarchicalCommunicator
+{
+    private:
+        Group& group;
+        const unsigned int nbThreads;
+
+        /* For each thread, the representative of its NUMA node */
+        std::vector<unsigned int> representatives;
+
+        /* First level: the threads of a NUMA node */
+        Communicator<T> localCommunicator;
+
+        /* Second level: the representatives, a data is a batch of the data of a NUMA node */
+        Communicator<std::vector<T>> nodeCommunicator;
+
+        /* For each representative, the data of its NUMA node not yet forwarded (only used by the representative) */
+        std::vector<std::vector<T>> batches;
+
+        /* Only the data accepted by this predicate are forwarded to the other NUMA nodes (an empty std::function accepts all data) */
+        std::function<bool(const T&)> forwardFilter;
+
+        static std::vector<unsigned int> computeRepresentatives(Group& g){
+            std::vector<unsigned int> ret(g.getNbThreads(), UINT_MAX);
+            std::vector<unsigned int> nodeRepresentatives(g.getNbNumaNodes(), UINT_MAX);
+            for (unsigned int i = 0; i < g.getNbThreads(); i++){
+                unsigned int &representative = nodeRepresentatives[g.getNumaNode(i)];
+                if (representative == UINT_MAX) representative = i;
+                ret[i] = representative;
+            }
+            return ret;
+        }
+
+        /* Each thread receives the data of the other threads of its NUMA node */
+        static Topology localTopology(Group& g){
+            std::vector<std::vector<unsigned int>> neighbors(g.getNbThreads());
+            for (unsigned int i = 0; i < g.getNbThreads(); i++)
+                for (unsigned int j = 0; j < g.getNbThreads(); j++)
+                    if (i != j && g.getNumaNode(i) == g.getNumaNode(j)) neighbors[i].push_back(j);
+            return Topology(neighbors);
+        }
+
+        /* Each representative receives the batches of the other representatives */
+        static Topology nodeTopology(Group& g){
+            std::vector<unsigned int> ret = computeRepresentatives(g);
+            std::vector<std::vector<unsigned int>> neighbors(g.getNbThreads());
+            for (unsigned int i = 0; i < g.getNbThreads(); i++)
+                for (unsigned int j = 0; j < g.getNbThreads(); j++)
+                    if (i != j && ret[i] == i && ret[j] == j) neighbors[i].push_back(j);
+            return Topology(neighbors);
+        }
+
+    public:
+        HierarchicalCommunicator(Group& g):
+            group(g),
+            nbThreads(g.getNbThreads()),
+            representatives(computeRepresentatives(g)),
+            localCommunicator(g, localTopology(g)),
+            nodeCommunicator(g, nodeTopology(g)),
+            batches(g.getNbThreads())
+        {}
+
+        inline bool isRepresentative(unsigned int threadId) const {return representatives[threadId] == threadId;}
+
+        /* Send a data to the other threads (of all NUMA nodes)
+          \param data Data to send
+        */
+        inline void send(T data)
+        {
+            const unsigned int threadId = group.getThreadId();
+            if (isRepresentative(threadId) && (!forwardFilter || forwardFilter(data))) batches[threadId].push_back(data);
+            localCommunicator.send(data);
+        }
+
+        /* Receive all elements from the communicator (the representative of a NUMA node also forwards and redistributes data)
+          \param data: Received elements
+        */
+        inline void recvAll(std::vector<T> &data)
+        {
+            const unsigned int threadId = group.getThreadId();
+            if (!isRepresentative(threadId)){
+                localCommunicator.recvAll(data);
+                return;
+            }
+            //Forward the data of this NUMA node to the others
+            std::vector<T> &batch = batches[threadId];
+            const std::size_t nbData = data.size();
+            localCommunicator.recvAll(data);
+            for (std::size_t i = nbData; i < data.size(); i++)
+                if (!forwardFilter || forwardFilter(data[i])) batch.push_back(data[i]);
+            if (!batch.empty()){
+                nodeCommunicator.send(batch);
+                batch.clear();
+            }
+            //Redistribute the data of the others NUMA nodes in this NUMA node
+            std::vector<std::vector<T>> nodeBatches;
+            nodeCommunicator.recvAll(nodeBatches);
+            for (std::vector<T> &nodeBatch : nodeBatches){
+                for (T &element : nodeBatch){
+                    localCommunicator.send(element);
+                    data.push_back(element);
+                }
+            }
+        }
+
+        /* Set the predicate that selects the data forwarded to the other NUMA nodes (e.g. only short clauses)
+        */
+        inline void setForwardFilter(const std::function<bool(const T&)> &filter){forwardFilter = filter;}
+
+        /* The communicators of the two levels (e.g. to set their capacity or their filters) */
+        inline Communicator<T>& getLocalCommunicator(){return localCommunicator;}
+        inline Communicator<std::vector<T>>& getNodeCommunicator(){return nodeCommunicator;}
+
+        inline unsigned int getNbSend(){return localCommunicator.getNbSend();}
+        inline unsigned int getNbRecv(){return localCommunicator.getNbRecv();}
+        /* Number of batches exchanged between the NUMA nodes */
+        inline unsigned int getNbNodeSend(){return nodeCommunicator.getNbSend();}
+};
+
+} // namespace pFactory
+
+#endif
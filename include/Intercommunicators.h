@@ -22,120 +22,64 @@
 
 namespace pFactory
 {
-    
+
+/* A communicator between groups: the threads of the sender groups send, the threads of the receiver group receive.
+   The threads are numbered in the order of the groups (the sender groups first), each thread uses the usual
+   send(), recv(), recvAll() and isEmpty() methods.
+   In bidirectional mode (one sender group), the threads of each group receive the data of the other group.
+*/
 template <class T>
 class Intercommunicator : public Communicator<T>
 {
     private:
-        Group& receiverGroup;
-
-    public:
-    
-        Intercommunicator(Group& psenderGroup, Group& preceiverGroup)
-            :Communicator<T>::Communicator(psenderGroup, std::vector<bool>(psenderGroup.getNbThreads(), true), std::vector<bool>(preceiverGroup.getNbThreads(), true), false),
-            receiverGroup(preceiverGroup)
+        static std::vector<Group*> allGroups(const std::vector<Group*>& senderGroups, Group& receiverGroup)
         {
-            initialize();
+            std::vector<Group*> ret(senderGroups);
+            for (Group* g : senderGroups) assert(g != &receiverGroup);
+            ret.push_back(&receiverGroup);
+            return ret;
         }
 
-        inline void initialize() {
-            unsigned int receiverNbThreads = receiverGroup.getNbThreads();
-            for (unsigned int i = 0; i < this->nbThreads; i++)
-            {
-                if (this->senders[i]){ //Only if i is a sender thread !
-                    this->createOrderPointer(i, receiverNbThreads);
-
-                    //Delete the non-receivers pointer
-                    for (unsigned int j = 0; j < receiverNbThreads; j++){
-                        if (!this->receivers[j]) this->removePointer(i, j);
-                    }
-                }
-            }
-        }
-
-        inline void recvAll(std::vector<T> &data)
+        /* Each receiver reads all the sender threads (and each sender reads all the receiver threads in bidirectional mode)
+         */
+        static Topology topology(const std::vector<Group*>& senderGroups, Group& receiverGroup, bool bidirectional)
         {
-            std::vector<T> noDataLast;
-            recvAll(data, noDataLast, false);
+            unsigned int nbSenders = Communicator<T>::countThreads(senderGroups);
+            unsigned int nbThreads = nbSenders + receiverGroup.getNbThreads();
+            std::vector<unsigned int> senderThreads, receiverThreads;
+            for (unsigned int i = 0; i < nbThreads; i++) (i < nbSenders ? senderThreads : receiverThreads).push_back(i);
+            std::vector<std::vector<unsigned int>> neighbors(nbThreads);
+            for (unsigned int i = 0; i < nbThreads; i++)
+                if (i >= nbSenders) neighbors[i] = senderThreads;
+                else if (bidirectional) neighbors[i] = receiverThreads;
+            return Topology(neighbors);
         }
-        
-        /* Receive all elements from the intercommunicator.
-           \param dataNotLast Elements which have not been received by all threads
-           \param dataLast Elements which have been received by all threads (others threads have already received the element)
-           Remark1: dataNotLast and dataLast are useful to deal with copy
-           Remark2: When no data is found, nothing is added in these two parameters
-        */
-        inline void recvAll(std::vector<T> &dataNotLast, std::vector<T> &dataLast, bool withDataLast = true) 
-        {
-            const unsigned int threadId = receiverGroup.getThreadId();
-            if (!this->receivers[threadId]) return; //If this thread is not a receiver, do nothing !
-
-            for (unsigned int threadIdQueue = 0; threadIdQueue < this->nbThreads; threadIdQueue++)
-            {
-                //Browse all queues except the queue of this thread and the queues from threads that are not a sender
-                if (this->senders[threadIdQueue])
-                {
-
-                    //These adresses don't move, so no mutex here !
-                    std::deque<T> &deque = this->vectorOfQueues[threadIdQueue];
-                    std::vector<unsigned int> &queuePointer = this->threadQueuesPointer[threadIdQueue];
-                    //Special issue if the watch of thread is at the end or that the vector is empty (no clause to recuperate)
-                    if (deque.empty() || queuePointer[threadId] == deque.size())
-                    {
-                        continue;
-                    }
-
-                    std::mutex &mutex = this->threadMutexs[threadIdQueue];
-                    unsigned int &minQueuePointer = this->minQueuesPointer[threadIdQueue];
-                    unsigned int &minSecondQueuePointer = this->minSecondQueuesPointer[threadIdQueue];
-                    std::vector<OrderPointer *> &ordersPointer = this->threadOrdersPointer[threadIdQueue];
 
-                    mutex.lock();
-
-                    //Verify the queue of pointers
-                    this->assertQueuePointerCriticalSection(threadIdQueue);
-
-                    //Get the minimum and the second minimum !
-                    minQueuePointer = queuePointer[this->threadOrdersPointerStart[threadIdQueue]->next->idThread];
-
-                    if (withDataLast){
-                        int idSecondQueuePointer = this->threadOrdersPointerStart[threadIdQueue]->next->next->idThread;
-                        minSecondQueuePointer = (idSecondQueuePointer == -1) ? deque.size() : queuePointer[idSecondQueuePointer];
-
-                        //Recuperate clauses that I have to no copy : it is the dataLast thread that take these clauses
-                        if (minQueuePointer == queuePointer[threadId])
-                        { //I am a minumum : there are may be dataLast clauses with no copy (this thread is at the smallest position)
-                            while (queuePointer[threadId] != minSecondQueuePointer)
-                            { // warning, that can be equals (severals minimums equals)!
-                                dataLast.push_back(deque[queuePointer[threadId]++]);
-                                this->nbRecv[threadId]++;
-                            }
-                        }
-                    }
-                    //Now, recuperate clauses that I have to copy
-                    while (queuePointer[threadId] != deque.size())
-                    {
-                        dataNotLast.push_back(deque[queuePointer[threadId]++]);
-                        this->nbRecv[threadId]++;
-                    }
-                    //At this time, this assertion have to be verify (no more clauses to recuperate)
-                    assert(queuePointer[threadId] == deque.size());
-
-                    //Update the ordersPointer 
-                    this->updateOrdersPointer(ordersPointer, threadIdQueue, threadId);
-
-                    //pop data already recuperate by all threads
-                    if (minQueuePointer > 1000) this->popDataReceived(minQueuePointer, threadIdQueue, queuePointer, deque);
+    public:
 
-                    mutex.unlock();
-                }
+        /* \param psenderGroup The threads that send
+           \param preceiverGroup The threads that receive
+           \param bidirectional If true, the threads of preceiverGroup also send to the threads of psenderGroup
+         */
+        Intercommunicator(Group& psenderGroup, Group& preceiverGroup, bool bidirectional = false)
+            : Intercommunicator(std::vector<Group*>(1, &psenderGroup), preceiverGroup, bidirectional)
+        {}
+
+        /* Fan-in: the threads of all sender groups send to the threads of the receiver group,
+           a recvAll() reads the queues of all sender groups at once
+         */
+        Intercommunicator(const std::vector<Group*>& senderGroups, Group& preceiverGroup, bool bidirectional = false)
+            : Communicator<T>::Communicator(allGroups(senderGroups, preceiverGroup), topology(senderGroups, preceiverGroup, bidirectional), false)
+        {
+            unsigned int nbSenders = Communicator<T>::countThreads(senderGroups);
+            for (unsigned int i = 0; i < this->nbThreads; i++){
+                this->senders[i] = bidirectional || i < nbSenders;
+                this->receivers[i] = bidirectional || i >= nbSenders;
             }
-            this->nbRecvAll[threadId]++;
+            this->initialize();
         }
-
-
 };
 
 } // namespace pFactory
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,64 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef metrics_H
+#define metrics_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace pFactory
+{
+
+/*
+ * A snapshot of the traffic of a Communicator (see Communicator::enableMetrics() and Communicator::getMetrics()).
+ * The counters are read without lock: a snapshot taken during the computation is consistent per counter only.
+ */
+class CommunicatorMetrics
+{
+public:
+    /* Latency histograms: the bucket b counts the latencies in [2^b, 2^(b+1)) nanoseconds */
+    static const unsigned int nbBuckets = 64;
+
+    explicit CommunicatorMetrics(unsigned int pnbThreads = 0);
+
+    unsigned int nbThreads;
+    std::vector<std::vector<uint64_t>> nbData;    /* nbData[sender][receiver]: data received */
+    std::vector<std::vector<uint64_t>> nbBytes;   /* nbBytes[sender][receiver]: bytes received */
+    std::vector<uint64_t> queueDepth;             /* For each sender, the data kept in its queue */
+    std::vector<uint64_t> queueHighWater;         /* For each sender, the maximum of queueDepth */
+    std::vector<uint64_t> lockWait;               /* For each thread, the nanoseconds spent waiting for a mutex of a queue */
+    std::vector<std::vector<uint64_t>> latencies; /* For each receiver, the histogram of the sampled send-to-receive latencies */
+
+    uint64_t getNbData() const;
+    uint64_t getNbBytes() const;
+    uint64_t getNbSamples() const;
+
+    /* An upper bound of the percentile of the sampled latencies in nanoseconds (e.g. 0.5 for the median)
+    */
+    uint64_t getLatencyPercentile(double percentile) const;
+
+    static inline unsigned int bucket(uint64_t nanoseconds){return 63 - __builtin_clzll(nanoseconds | 1);}
+};
+
+/* Display a snapshot: one line per active thread, then the latencies */
+std::ostream& operator<<(std::ostream& os, const CommunicatorMetrics& metrics);
+
+} // namespace pFactory
+
+#endif
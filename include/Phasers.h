@@ -0,0 +1,167 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef phasers_H
+#define phasers_H
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Groups.h"
+#include "Eventcounts.h"
+
+namespace pFactory
+{
+
+/*
+ * A barrier whose number of parties changes at runtime (a phaser): a party registers (registerParty()), arrives at
+ * the end of each phase and deregisters (arriveAndDeregister()). A phase ends when all registered parties have arrived.
+ * Arrival and waiting are split: arrive() does not block, so a thread can work before awaitAdvance() (or poll with
+ * hasAdvanced()); arriveAndAwaitAdvance() is the usual barrier.
+ * With a group: each task is a party (registered at its start, deregistered at its end, so a task that ends early or a
+ * thread without task never blocks the others) and a stopped group never hangs in awaitAdvance().
+ * The state (phase, parties, parties not arrived) is one atomic word: at most 65535 parties.
+ */
+class Phaser
+{
+public:
+    /* \param pnbParties The number of parties registered at the start (see registerParty())
+    */
+    explicit Phaser(unsigned int pnbParties = 0);
+
+    /* A phaser for the tasks of a group
+       \param g The group
+       \param autoRegister True to register each task of the group (the first phase waits for the tasks started with
+       the group), false if the tasks call registerParty() (they are deregistered at their end)
+       Warning: has to be created before the start of the group
+    */
+    explicit Phaser(Group& g, bool autoRegister = true);
+
+    Phaser(const Phaser&) = delete;
+    Phaser& operator=(const Phaser&) = delete;
+
+    ~Phaser();
+
+    /* Add a party to the current phase (called by a task of the group: it is deregistered at the end of the task)
+       \return The current phase
+    */
+    int registerParty();
+
+    /* Arrive at the end of the current phase without waiting
+       \return The phase arrived at (for awaitAdvance())
+    */
+    inline int arrive() {return arrive(false);}
+
+    /* Arrive and remove this party (called by a task of the group: it is no longer deregistered at its end)
+       \return The phase arrived at
+    */
+    int arriveAndDeregister();
+
+    /* Wait for the end of a phase: spin for a bounded time, then sleep
+       \param phase The phase returned by arrive()
+       \return The next phase, -1 if the group is stopped
+    */
+    inline int awaitAdvance(int phase)
+    {
+        for (unsigned int i = 0; i < nbSpins; i++){
+            if (hasAdvanced(phase)) return getPhase();
+            cpuRelax();
+        }
+        while (!hasAdvanced(phase)){
+            if (group && group->isStopped()) return -1; //The stop of a group is not notified: checked at each timeout
+            const uint32_t key = advanced.prepareWait();
+            if (hasAdvanced(phase)){
+                advanced.cancelWait();
+                break;
+            }
+            advanced.wait(key, std::chrono::milliseconds(10));
+        }
+        return getPhase();
+    }
+
+    /* Arrive and wait for the other parties (as Barrier::wait())
+       \return The next phase, -1 if the group is stopped
+    */
+    inline int arriveAndAwaitAdvance() {return awaitAdvance(arrive());}
+
+    /* Say if a phase is ended (to poll instead of awaitAdvance()) */
+    inline bool hasAdvanced(int phase) const {return getPhase() != phase;}
+
+    inline int getPhase() const {return phaseOf(state.load(std::memory_order_acquire));}
+    inline unsigned int getNbParties() const {return partiesOf(state.load(std::memory_order_acquire));}
+    inline unsigned int getNbUnarrived() const {return unarrivedOf(state.load(std::memory_order_acquire));}
+
+private:
+    /* The state: the phase (31 bits), the number of parties (16 bits) and the number of parties not arrived (16 bits) */
+    std::atomic<uint64_t> state;
+    EventCount advanced; /* The parties sleeping until the end of their phase */
+    unsigned int nbSpins;
+
+    /* With a group: the threads whose task is a party, registered at the start of the group or by registerParty() */
+    Group* group;
+    unsigned int listenerId;
+    std::mutex registrationMutex;
+    bool autoRegister;
+    std::vector<char> registeredThreads;
+    std::vector<int> lastArrivals; /* Per thread, the last phase arrived at (written by the thread only) */
+    unsigned int nbReserved; /* The parties registered at the start of the group and not yet taken by a task */
+    bool reserved;
+
+    static inline int phaseOf(uint64_t s) {return (int)(s >> 32);}
+    static inline unsigned int partiesOf(uint64_t s) {return (unsigned int)((s >> 16) & 0xFFFF);}
+    static inline unsigned int unarrivedOf(uint64_t s) {return (unsigned int)(s & 0xFFFF);}
+    static inline uint64_t makeState(int phase, unsigned int parties, unsigned int unarrived){
+        return ((uint64_t)(uint32_t)phase << 32) | ((uint64_t)parties << 16) | unarrived;
+    }
+
+    /* Arrive (and deregister): the last party to arrive starts the next phase
+    */
+    inline int arrive(bool deregister)
+    {
+        uint64_t s = state.load(std::memory_order_relaxed);
+        while (true){
+            const int phase = phaseOf(s);
+            const unsigned int parties = partiesOf(s) - (deregister ? 1 : 0);
+            const unsigned int unarrived = unarrivedOf(s);
+            assert(unarrived > 0); //The caller is not a registered party
+            const uint64_t next = unarrived == 1 ? makeState((phase + 1) & INT32_MAX, parties, parties) : makeState(phase, parties, unarrived - 1);
+            if (state.compare_exchange_weak(s, next, std::memory_order_acq_rel, std::memory_order_relaxed)){
+                if (unarrived == 1) advanced.notifyAll();
+                if (group && Group::getCurrentGroup() == group) lastArrivals[group->getThreadId()] = phase;
+                return phase;
+            }
+        }
+    }
+
+    /* Remove the party of a task at its end (it may have already arrived at the current phase) */
+    void deregister(unsigned int threadId);
+
+    /* Add some parties to the current phase */
+    int addParties(unsigned int nb);
+
+    /* The task listener of the group */
+    void onStart(unsigned int threadId);
+    void onEnd(unsigned int threadId);
+};
+
+} // namespace pFactory
+
+#endif
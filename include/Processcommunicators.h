@@ -0,0 +1,286 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef processcommunicators_H
+#define processcommunicators_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include <signal.h>
+#include <unistd.h>
+#include "Sharedmemories.h"
+
+namespace pFactory
+{
+
+/*
+ * A communicator between processes (e.g. the members of a portfolio run as separate processes for their memory
+ * limits or their crash isolation), with the same send()/recvAll() as a Communicator: each process is a thread of
+ * the communicator, identified by its rank.
+ * The data are copied in a SharedMemory: one ring of capacity data per sender, written by its process only and read
+ * without lock by the others (each reader keeps its own positions).
+ * A sender never waits for a receiver: when a ring is full, its oldest data are overwritten and a receiver that has
+ * not read them counts them as dropped (see getNbDropped()). So a process that dies or stops receiving never blocks
+ * the others, and the data sent by a dead process before its death are still received.
+ * A receiver copies the data then checks that the sender has not overwritten them meanwhile (as a seqlock).
+ * Warning: T has to be trivially copyable, only one thread of a process sends
+ */
+template <class T>
+class ProcessCommunicator
+{
+    static_assert(std::is_trivially_copyable<T>::value, "A ProcessCommunicator needs a trivially copyable type");
+
+private:
+    struct Header
+    {
+        uint32_t nbProcesses;
+        uint32_t capacity;
+        uint64_t dataSize;
+    };
+
+    /* The state of the ring of a sender */
+    struct alignas(64) Ring
+    {
+        std::atomic<uint64_t> writing; /* Position of the data being written + 1 (equal to head between two writes) */
+        std::atomic<uint64_t> head;    /* Number of data written */
+        std::atomic<uint64_t> owner;   /* The process of this rank (see ownerOf()), 0 if none has joined */
+    };
+
+    SharedMemory memory;
+    const unsigned int nbProcesses;
+    const unsigned int capacity;
+    const uint64_t mask;
+    unsigned int rank;
+    Header* header;
+    Ring* rings;
+    T* slots;
+
+    std::vector<uint64_t> positions; /* Per sender, the position of this process (local: nobody waits for it) */
+    unsigned int nbSend;
+    unsigned int nbRecv;
+    unsigned int nbDropped;
+
+    static inline std::size_t segmentSize(unsigned int pnbProcesses, unsigned int pcapacity)
+    {
+        return 64 + pnbProcesses * (sizeof(Ring) + (std::size_t)pcapacity * sizeof(T));
+    }
+
+    static inline unsigned int roundCapacity(unsigned int pcapacity)
+    {
+        unsigned int ret = 1;
+        while (ret < pcapacity) ret <<= 1;
+        return ret;
+    }
+
+    inline void map()
+    {
+        header = static_cast<Header*>(memory.getAddress());
+        rings = reinterpret_cast<Ring*>(static_cast<char*>(memory.getAddress()) + 64);
+        slots = reinterpret_cast<T*>(rings + nbProcesses);
+        if (memory.isCreator()){
+            header->nbProcesses = nbProcesses;
+            header->capacity = capacity;
+            header->dataSize = sizeof(T);
+            memory.ready();
+        }else if (header->nbProcesses != nbProcesses || header->capacity != capacity || header->dataSize != sizeof(T)){
+            errno = EINVAL;
+            throw std::system_error(errno, std::generic_category(), "pFactory shared memory: another communicator in " + memory.getName());
+        }
+    }
+
+    /* A process: its pid and the low bits of its start time (a new process that reuses the pid is another owner) */
+    static inline uint64_t ownerOf(int32_t pid)
+    {
+        return (uint64_t)(uint32_t)pid << 32 | (uint32_t)getProcessStartTime(pid);
+    }
+
+    static inline bool isRunning(uint64_t owner)
+    {
+        const int32_t pid = (int32_t)(owner >> 32);
+        return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM) && ownerOf(pid) == owner;
+    }
+
+public:
+    /* Create or join a communicator between processes. The segment is removed when the process that created it
+       destroys its communicator; after a crash of this process, call SharedMemory::remove(name) before a new run
+       (otherwise the new run joins the old segment and receives its data).
+          \param name The name of the shared memory (e.g. "/mysolver"), the same for all processes
+          \param pnbProcesses The number of processes
+          \param prank The rank of this process (in [0, pnbProcesses))
+          \param pcapacity The number of data of the ring of each sender (rounded up to a power of two)
+        */
+    ProcessCommunicator(const std::string& name, unsigned int pnbProcesses, unsigned int prank, unsigned int pcapacity = 1 << 16)
+        : memory(name, segmentSize(pnbProcesses, roundCapacity(pcapacity))),
+        nbProcesses(pnbProcesses),
+        capacity(roundCapacity(pcapacity)),
+        mask(capacity - 1),
+        rank(UINT_MAX),
+        positions(pnbProcesses, 0),
+        nbSend(0),
+        nbRecv(0),
+        nbDropped(0)
+    {
+        map();
+        join(prank);
+    }
+
+    /* Create a communicator in an anonymous shared memory: the processes forked afterwards call join() with their rank
+          \param pnbProcesses The number of processes
+          \param pcapacity The number of data of the ring of each sender (rounded up to a power of two)
+        */
+    explicit ProcessCommunicator(unsigned int pnbProcesses, unsigned int pcapacity = 1 << 16)
+        : memory(segmentSize(pnbProcesses, roundCapacity(pcapacity))),
+        nbProcesses(pnbProcesses),
+        capacity(roundCapacity(pcapacity)),
+        mask(capacity - 1),
+        rank(UINT_MAX),
+        positions(pnbProcesses, 0),
+        nbSend(0),
+        nbRecv(0),
+        nbDropped(0)
+    {
+        map();
+    }
+
+    /* Take a rank: this process sends in the ring of this rank and receives all data sent, including the ones sent
+       before it joined (those already overwritten are counted as dropped).
+       A process restarted after a crash can take the rank of the dead one (its ring continues), even if the pid of the
+       dead one has been reused by another process (a rank keeps the start time of its process with its pid).
+          \param prank The rank of this process
+        */
+    inline void join(unsigned int prank)
+    {
+        assert(prank < nbProcesses);
+        Ring &ring = rings[prank];
+        const uint64_t owner = ownerOf(getpid());
+        uint64_t previous = ring.owner.load();
+        //Two processes may claim a dead rank at the same time: only one exchange succeeds, the other sees a running owner
+        while (previous != owner){
+            if (isRunning(previous)){
+                errno = EBUSY;
+                throw std::system_error(errno, std::generic_category(), "pFactory shared memory: rank already taken in " + memory.getName());
+            }
+            if (ring.owner.compare_exchange_weak(previous, owner)) break;
+        }
+        //The previous process of this rank may have died while writing a data
+        ring.writing.store(ring.head.load());
+        rank = prank;
+        for (unsigned int i = 0; i < nbProcesses; i++) positions[i] = 0;
+        nbSend = nbRecv = nbDropped = 0;
+    }
+
+    inline unsigned int getRank() const {return rank;}
+    inline unsigned int getNbProcesses() const {return nbProcesses;}
+    inline unsigned int getCapacity() const {return capacity;}
+
+    /* Send a data to the other processes (never blocks: the oldest data of the ring may be overwritten)
+          \param data Data to send
+        */
+    inline void send(const T& data)
+    {
+        Ring &ring = rings[rank];
+        const uint64_t head = ring.head.load(std::memory_order_relaxed);
+        ring.writing.store(head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release); //The readers see writing before the new data
+        memcpy(&slots[(std::size_t)rank * capacity + (head & mask)], &data, sizeof(T));
+        ring.head.store(head + 1, std::memory_order_release);
+        nbSend++;
+    }
+
+    /* Same as send() (a ring is never full): for the same API as a Communicator
+          \return true
+        */
+    inline bool trySend(const T& data)
+    {
+        send(data);
+        return true;
+    }
+
+    /* Receive all data sent by the other processes since the last call
+          \param data The received data are added at its end
+        */
+    inline void recvAll(std::vector<T>& data)
+    {
+        for (unsigned int sender = 0; sender < nbProcesses; sender++){
+            if (sender == rank) continue;
+            Ring &ring = rings[sender];
+            uint64_t &position = positions[sender];
+            const uint64_t head = ring.head.load(std::memory_order_acquire);
+            if (position >= head) continue;
+            if (head - position > capacity){ //Overwritten before this process read them
+                nbDropped += head - capacity - position;
+                position = head - capacity;
+            }
+            //Copy the data (at most two parts: the end then the start of the ring)
+            const std::size_t start = data.size();
+            const std::size_t nb = head - position;
+            data.resize(start + nb);
+            const T* ringSlots = &slots[(std::size_t)sender * capacity];
+            const std::size_t first = std::min<std::size_t>(nb, capacity - (position & mask));
+            memcpy(&data[start], &ringSlots[position & mask], first * sizeof(T));
+            if (first < nb) memcpy(&data[start + first], ringSlots, (nb - first) * sizeof(T));
+            //The data before writing - capacity may have been overwritten during the copy
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t writing = ring.writing.load(std::memory_order_relaxed);
+            if (writing > capacity && position < writing - capacity){
+                const std::size_t nbOverwritten = std::min<uint64_t>(head, writing - capacity) - position;
+                data.erase(data.begin() + start, data.begin() + start + nbOverwritten);
+                nbDropped += nbOverwritten;
+            }
+            nbRecv += data.size() - start;
+            position = head;
+        }
+    }
+
+    /* Say if there are data to recuperate
+        */
+    inline bool isEmpty() const
+    {
+        for (unsigned int sender = 0; sender < nbProcesses; sender++)
+            if (sender != rank && positions[sender] < rings[sender].head.load(std::memory_order_acquire)) return false;
+        return true;
+    }
+
+    /* Say if the process of a rank is running (false if it has died or not joined yet)
+        */
+    inline bool isAlive(unsigned int prank) const {return isRunning(rings[prank].owner.load());}
+
+    inline unsigned int getNbAlive() const
+    {
+        unsigned int ret = 0;
+        for (unsigned int i = 0; i < nbProcesses; i++) ret += isAlive(i);
+        return ret;
+    }
+
+    /* The counters of this process */
+    inline unsigned int getNbSend() const {return nbSend;}
+    inline unsigned int getNbRecv() const {return nbRecv;}
+    inline unsigned int getNbDropped() const {return nbDropped;}
+};
+
+} // namespace pFactory
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef processgroups_H
+#define processgroups_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+#include "Task.h"
+#include "Sharedmemories.h"
+
+namespace pFactory {
+
+    /* A group of worker processes: the same role as a Group, with the fault isolation of processes.
+       The workers are forked at the first start() and reused by the next tasks (and after reload()).
+       A task is a registered function (see registerFunction()) and an argument: it is run by a worker, its return code
+       and its result (see setResult()) come back through a shared memory, as the stop of the group.
+       A worker that crashes (segmentation fault, memory limit, ...) makes its task failed (Status::failed) and is
+       replaced by a new worker: the other tasks go on. When no worker can be forked, the remaining tasks are failed
+       (return code -1).
+       Warning: the functions are registered before the first start(), a task communicates with the other processes
+       only through its result or a ProcessCommunicator
+    */
+    class ProcessGroup {
+        static unsigned int groupCount; //To get the id of a group
+
+    public:
+        /* \param pnbWorkers The number of worker processes
+           \param pmemoryLimit The maximum number of bytes of the address space of each worker (0 for no limit)
+           \param pmessageSize The maximum number of bytes of the argument and of the result of a task
+        */
+        explicit ProcessGroup(unsigned int pnbWorkers, std::size_t pmemoryLimit = 0, std::size_t pmessageSize = 4096);
+
+        ProcessGroup(const ProcessGroup&) = delete;
+        ProcessGroup& operator=(const ProcessGroup&) = delete;
+
+        ~ProcessGroup();
+
+        /* Register a function that a task can run
+           \param function The function, called with the argument of the task, that returns the return code of the task
+           \return The identifier of the function for add()
+           Warning: has to be called before the first start() (the workers get the functions when they are forked)
+        */
+        unsigned int registerFunction(const std::function<int(const std::string&)>& function);
+
+        /* Add a task
+           \param functionId The function to run (see registerFunction())
+           \param argument Its argument (at most messageSize bytes)
+        */
+        void add(unsigned int functionId, const std::string& argument = std::string());
+
+        /* Start the computation of the tasks by the workers (forks them at the first call, and the missing ones after) */
+        void start();
+
+        /* Wait the end of all tasks (or, in concurrent mode, the end of the running ones after the first)
+           \return The return code of the winner in concurrent mode, 0 otherwise
+        */
+        int wait();
+
+        /* Stop the group and kill the workers that run a task (their tasks are failed, the workers are replaced)
+        */
+        int kill();
+
+        /* Reuse the group (and its workers) for new tasks */
+        void reload();
+
+        inline ProcessGroup& concurrent(){
+            concurrentMode = true;
+            return *this;
+        }
+
+        /* To stop the tasks: a task checks isStopped() (in its worker) */
+        void stop();
+        bool isStopped() const;
+
+        /* In a task: the worker that runs it (in [0, nbWorkers)), UINT_MAX in the parent process */
+        inline unsigned int getWorkerId() const {return workerId;}
+
+        /* In a task: its result, read by the parent process with getResult() (truncated to messageSize bytes) */
+        void setResult(const std::string& result);
+
+        inline unsigned int getId() const {return idGroup;}
+        inline unsigned int getNbWorkers() const {return nbWorkers;}
+        inline unsigned int getNbTasks() const {return tasks.size();}
+        inline unsigned int getNbCrashes() const {return nbCrashes;}
+        inline std::vector<Task>& getTasks() {return tasks;}
+        inline const std::string& getResult(unsigned int taskId) const {return results[taskId];}
+        inline Task& getWinner() {return tasks[winnerId];}
+
+    private:
+        /* The shared state of a worker */
+        struct alignas(64) Slot
+        {
+            std::atomic<uint32_t> state;
+            uint32_t functionId;
+            int32_t returnCode;
+            uint32_t argumentSize;
+            uint32_t resultSize;
+        };
+        enum SlotState : uint32_t {idle, assigned, running, done, exiting};
+
+        struct Control
+        {
+            std::atomic<uint32_t> stop;
+            std::atomic<uint32_t> events; /* Incremented by a worker at the end of a task (the dispatcher sleeps on it) */
+        };
+
+        inline Control* control() const {return static_cast<Control*>(memory.getAddress());}
+        inline Slot* slot(unsigned int worker) const
+        {
+            return reinterpret_cast<Slot*>(static_cast<char*>(memory.getAddress()) + 64 + worker * slotSize);
+        }
+        inline char* argument(unsigned int worker) const {return reinterpret_cast<char*>(slot(worker) + 1);}
+        inline char* result(unsigned int worker) const {return argument(worker) + messageSize;}
+
+        void fork(unsigned int worker);
+        void workerLoop();
+        void dispatch();
+        bool collect(unsigned int worker);
+        void fail(unsigned int worker, int status);
+
+        unsigned int idGroup;
+        const unsigned int nbWorkers;
+        const std::size_t memoryLimit;
+        const std::size_t messageSize;
+        const std::size_t slotSize;
+        SharedMemory memory;
+
+        std::vector<std::function<int(const std::string&)>> functions;
+        std::vector<pid_t> pids;
+        std::vector<unsigned int> workerTasks; /* The task of each worker (UINT_MAX if none) */
+        unsigned int workerId;
+        pid_t parentPid;
+        std::atomic<bool> killing;
+
+        std::vector<Task> tasks;
+        std::vector<unsigned int> taskFunctions;
+        std::vector<std::string> taskArguments;
+        std::vector<std::string> results;
+        unsigned int nextTask;
+        unsigned int winnerId;
+        unsigned int nbCrashes;
+        bool concurrentMode;
+        bool forked;
+        bool hasStarted;
+        bool hasWaited;
+        std::thread* dispatcher;
+    };
+}
+
+#endif
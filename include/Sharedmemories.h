@@ -0,0 +1,92 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef sharedmemories_H
+#define sharedmemories_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace pFactory
+{
+
+/*
+ * A memory segment shared by several processes (POSIX shared memory, mapped with mmap).
+ * A named segment is created by the first process that opens it and joined by the others: the creator initializes
+ * its content then calls ready(), the others wait for it in their constructor. The name is removed by the destructor
+ * of the creator: a process that opens it afterwards creates a new segment. When the creator has crashed, its segment
+ * remains (with its old content) until remove() is called: call it before a new run with the same name.
+ * An anonymous segment is shared with the processes forked after its creation.
+ * The memory is zeroed at creation. Errors are reported by a std::system_error.
+ */
+class SharedMemory
+{
+private:
+    struct Header
+    {
+        std::atomic<uint64_t> state; /* readyState once the creator has initialized the segment */
+        uint64_t size;
+    };
+    static const uint64_t readyState = 0x7046616374727921ULL;
+    static const std::size_t headerSize = 64; /* The content starts on its own cache line */
+
+    std::string name;
+    std::size_t size;
+    bool creator;
+    void* memory;
+
+    inline Header* header() const {return static_cast<Header*>(memory);}
+
+public:
+    /* Create or join a named segment
+       \param pname The name of the segment (e.g. "/mysolver")
+       \param psize The number of bytes of the content
+       \param timeout The maximum time to wait for the creator (in milliseconds)
+    */
+    SharedMemory(const std::string& pname, std::size_t psize, unsigned int timeout = 10000);
+
+    /* Create an anonymous segment (shared with the child processes forked afterwards)
+       \param psize The number of bytes of the content
+    */
+    explicit SharedMemory(std::size_t psize);
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    ~SharedMemory();
+
+    /* The content is initialized: the processes waiting in the constructor can use it */
+    void ready();
+
+    /* Remove a named segment, e.g. the one left by a crashed creator (the processes that have mapped it keep it until
+       their destructor) */
+    static void remove(const std::string& name);
+
+    inline void* getAddress() const {return static_cast<char*>(memory) + headerSize;}
+    inline std::size_t getSize() const {return size;}
+    inline bool isCreator() const {return creator;}
+    inline const std::string& getName() const {return name;}
+};
+
+/* The start time of a process in clock ticks since the boot (to detect the reuse of its pid), 0 if it is unknown
+*/
+uint64_t getProcessStartTime(int pid);
+
+} // namespace pFactory
+
+#endif
@@ -11,6 +11,7 @@ namespace pFactory{
         notStarted, // Tasks not started yet
         inProgress, // Tasks in progress
         terminated, // Tasks that have finished normaly theirs works
+        failed,     // Tasks whose worker process has crashed (see ProcessGroup)
     };
 
     inline std::ostream& operator<<(std::ostream& os, Status c)
@@ -20,6 +21,7 @@ namespace pFactory{
             case Status::notStarted: os << "notStarted";    break;
             case Status::inProgress: os << "inProgress"; break;
             case Status::terminated: os << "terminated";  break;
+            case Status::failed: os << "failed";  break;
             default: os.setstate(std::ios_base::failbit);
         }
         return os;
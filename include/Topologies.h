@@ -0,0 +1,79 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef topologies_H
+#define topologies_H
+
+#include <vector>
+#include <climits>
+
+namespace pFactory
+{
+
+/*
+ * A topology says, for each thread of a group, the threads whose data it receives (its neighbors).
+ * Used by a Communicator: a thread only reads the queues of its neighbors, so the cost of a recvAll() is O(degree).
+ * Data are not forwarded by the neighbors (except by the hub of Topology::hub()).
+ */
+class Topology
+{
+public:
+    /* Custom topology
+       \param pneighbors For each thread, the threads whose data it receives
+    */
+    explicit Topology(const std::vector<std::vector<unsigned int>>& pneighbors);
+
+    /* All-to-all (the default topology of a Communicator) */
+    static Topology complete(unsigned int nbThreads);
+
+    /* Each thread receives the data of its predecessor and its successor */
+    static Topology ring(unsigned int nbThreads);
+
+    /* A tree of arity k rooted at the thread 0, each thread receives the data of its parent and its children */
+    static Topology tree(unsigned int nbThreads, unsigned int arity = 2);
+
+    /* Each thread receives the data of the threads whose id differs by one bit */
+    static Topology hypercube(unsigned int nbThreads);
+
+    /* Each thread receives the data of degree random threads, re-drawn every period calls of recvAll() by this thread
+       (the data sent by a thread before becoming a neighbor are not received)
+    */
+    static Topology gossip(unsigned int nbThreads, unsigned int degree, unsigned int period = 100);
+
+    /* All threads send their data to the hub thread (in [0, nbThreads)) which forwards them to all other threads
+       Warning: the data of the other threads are forwarded only when the hub calls recvAll() or recv()
+    */
+    static Topology hub(unsigned int nbThreads, unsigned int hubThread = 0);
+
+    inline unsigned int getNbThreads() const {return neighbors.size();}
+    inline const std::vector<unsigned int>& getNeighbors(unsigned int threadId) const {return neighbors[threadId];}
+    inline unsigned int getDegree(unsigned int threadId) const {return neighbors[threadId].size();}
+
+    inline unsigned int getGossipDegree() const {return gossipDegree;}
+    inline unsigned int getGossipPeriod() const {return gossipPeriod;}
+    inline unsigned int getHub() const {return hubThread;}
+
+private:
+    std::vector<std::vector<unsigned int>> neighbors;
+    unsigned int gossipDegree; /* 0 if it is not a gossip topology */
+    unsigned int gossipPeriod;
+    unsigned int hubThread; /* UINT_MAX if it is not a hub topology */
+};
+
+} // namespace pFactory
+
+#endif
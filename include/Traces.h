@@ -0,0 +1,297 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef traces_H
+#define traces_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Groups.h"
+
+namespace pFactory
+{
+
+enum class TraceEventType : uint8_t {
+    send,    // A data sent by send() or trySend() (not throttled nor dropped), with its bytes
+    recvAll, // A call of recvAll()
+    recv,    // A call of recv()
+    advance  // The position of a receiver in the queue of a sender has moved (data received or skipped)
+};
+
+/*
+ * Records the traffic of a communicator (see Communicator::record()) in a binary trace file, mapped in memory.
+ * Each thread writes its events in its own buffer. A full buffer is copied at once in the file (a chunk), so the
+ * threads only share an atomic offset. The events are compact: a type, the time since the previous event of the
+ * thread and varint fields.
+ * Warning: the recorder has to be destroyed (or closed) when the threads do not use it anymore
+ */
+class TraceRecorder
+{
+public:
+    /* \param path The trace file (created or truncated)
+       \param pnbThreads The number of threads of the recorded communicator
+       \param pmaxBytes The maximum size of the trace (the events beyond are lost, see getNbLost())
+       \param pbufferSize The size of the buffer of each thread
+    */
+    TraceRecorder(const std::string& path, unsigned int pnbThreads, std::size_t pmaxBytes = (std::size_t)1 << 30, std::size_t pbufferSize = 1 << 16);
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+    ~TraceRecorder();
+
+    inline void send(unsigned int thread, const uint8_t* payload, std::size_t bytes)
+    {
+        Buffer& buffer = begin(thread, TraceEventType::send, bytes + 10);
+        putVarint(buffer, bytes);
+        if (bytes) buffer.data.insert(buffer.data.end(), payload, payload + bytes);
+        end(buffer);
+    }
+
+    inline void recvAll(unsigned int thread) {end(begin(thread, TraceEventType::recvAll, 0));}
+    inline void recv(unsigned int thread) {end(begin(thread, TraceEventType::recv, 0));}
+
+    inline void advance(unsigned int thread, unsigned int sender, uint64_t from, uint64_t to)
+    {
+        Buffer& buffer = begin(thread, TraceEventType::advance, 30);
+        putVarint(buffer, sender);
+        putVarint(buffer, from);
+        putVarint(buffer, to - from);
+        end(buffer);
+    }
+
+    /* Write the buffer of a thread in the file (by the thread itself or when no thread records) */
+    void flush(unsigned int thread);
+
+    /* Flush all buffers and close the file (called by the destructor) */
+    void close();
+
+    inline unsigned int getNbThreads() const {return nbThreads;}
+    inline uint64_t getNbBytes() const {return offset.load();}
+    uint64_t getNbEvents() const;
+    inline uint64_t getNbLost() const {return nbLost.load();}
+
+private:
+    struct alignas(64) Buffer
+    {
+        std::vector<uint8_t> data;
+        int64_t base;     /* Time of the first event of the chunk */
+        int64_t last;     /* Time of the last event */
+        uint64_t nbEvents;
+        uint64_t nbChunkEvents;
+    };
+
+    static inline void putVarint(Buffer& buffer, uint64_t value)
+    {
+        while (value >= 0x80){
+            buffer.data.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        buffer.data.push_back((uint8_t)value);
+    }
+
+    inline int64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    inline Buffer& begin(unsigned int thread, TraceEventType type, std::size_t bytes)
+    {
+        Buffer& buffer = buffers[thread];
+        if (buffer.data.size() + bytes + 11 > bufferSize && buffer.nbChunkEvents) flush(thread);
+        const int64_t time = now();
+        if (buffer.nbChunkEvents == 0) buffer.base = buffer.last = time;
+        buffer.data.push_back((uint8_t)type);
+        putVarint(buffer, (uint64_t)(time - buffer.last));
+        buffer.last = time;
+        return buffer;
+    }
+
+    static inline void end(Buffer& buffer)
+    {
+        buffer.nbEvents++;
+        buffer.nbChunkEvents++;
+    }
+
+    const unsigned int nbThreads;
+    const std::size_t maxBytes;
+    const std::size_t bufferSize;
+    const std::chrono::steady_clock::time_point start;
+    int fd;
+    uint8_t* memory;
+    std::atomic<uint64_t> offset;
+    std::atomic<uint64_t> nbLost;
+    std::vector<Buffer> buffers;
+};
+
+/* An event of a trace (see TraceReader) */
+struct TraceEvent
+{
+    TraceEventType type;
+    unsigned int thread;
+    int64_t timestamp;       /* Nanoseconds since the creation of the recorder */
+    unsigned int sender;     /* advance: the queue */
+    uint64_t position;       /* advance: the previous position of the receiver */
+    uint64_t count;          /* advance: the number of positions */
+    const uint8_t* payload;  /* send: the bytes of the data (in the mapped trace) */
+    std::size_t payloadSize;
+};
+
+/*
+ * Reads a trace file written by a TraceRecorder (mapped in memory: the payloads are not copied)
+ */
+class TraceReader
+{
+public:
+    explicit TraceReader(const std::string& path);
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+    ~TraceReader();
+
+    inline unsigned int getNbThreads() const {return nbThreads;}
+
+    /* All events, by timestamp */
+    inline const std::vector<TraceEvent>& getEvents() const {return events;}
+
+    /* The events of a thread, in their order */
+    inline const std::vector<TraceEvent>& getEvents(unsigned int thread) const {return threadEvents[thread];}
+
+private:
+    unsigned int nbThreads;
+    uint8_t* memory;
+    std::size_t size;
+    std::vector<TraceEvent> events;
+    std::vector<std::vector<TraceEvent>> threadEvents;
+};
+
+/* The bytes of a data in a trace: provided for the trivially copyable types and their std::vector
+*/
+template <class T, class Enable = void>
+struct TraceEncoding;
+
+template <class T>
+struct TraceEncoding<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type>
+{
+    static inline void encode(const T& data, std::vector<uint8_t>& bytes)
+    {
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(&data);
+        bytes.assign(begin, begin + sizeof(T));
+    }
+
+    static inline void decode(const uint8_t* bytes, std::size_t, T& data) {memcpy(&data, bytes, sizeof(T));}
+};
+
+template <class U>
+struct TraceEncoding<std::vector<U>, typename std::enable_if<std::is_trivially_copyable<U>::value>::type>
+{
+    static inline void encode(const std::vector<U>& data, std::vector<uint8_t>& bytes)
+    {
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(data.data());
+        bytes.assign(begin, begin + data.size() * sizeof(U));
+    }
+
+    static inline void decode(const uint8_t* bytes, std::size_t size, std::vector<U>& data)
+    {
+        data.resize(size / sizeof(U));
+        if (size) memcpy(data.data(), bytes, size);
+    }
+};
+
+/* The result of a replay */
+struct ReplayStatistics
+{
+    double seconds;       /* The longest replay of a thread */
+    uint64_t nbSend;
+    uint64_t nbRecvAll;
+    uint64_t nbReceived;  /* The data received by the replayed calls */
+};
+
+/* Replay a trace through a communicator (any implementation with send(), recvAll() and recv()): each thread of the
+   group calls send(), recvAll() and recv() as the same thread of the trace did, at full speed (the data are decoded
+   before). Several sharing engines can then be compared on the same workload.
+      \param trace The trace
+      \param group A group of trace.getNbThreads() threads, without task
+      \param communicator The communicator of the group
+      \param decode To build a data from its bytes in the trace
+*/
+template <class T, class C>
+ReplayStatistics replay(const TraceReader& trace, Group& group, C& communicator,
+    const std::function<void(const uint8_t*, std::size_t, T&)>& decode = &TraceEncoding<T>::decode)
+{
+    assert(group.getNbThreads() == trace.getNbThreads());
+    const unsigned int nbThreads = trace.getNbThreads();
+    std::vector<std::vector<T>> sends(nbThreads);
+    for (unsigned int thread = 0; thread < nbThreads; thread++){
+        for (const TraceEvent& event : trace.getEvents(thread)){
+            if (event.type != TraceEventType::send) continue;
+            sends[thread].push_back(T());
+            decode(event.payload, event.payloadSize, sends[thread].back());
+        }
+    }
+    std::vector<double> seconds(nbThreads, 0);
+    std::atomic<uint64_t> nbRecvAll(0), nbReceived(0);
+    for (unsigned int i = 0; i < nbThreads; i++){
+        group.add([&]() {
+            const unsigned int thread = group.getThreadId();
+            std::vector<T> data;
+            T one;
+            std::size_t nextSend = 0;
+            uint64_t nbThreadRecvAll = 0, nbThreadReceived = 0;
+            group.barrier.wait();
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (const TraceEvent& event : trace.getEvents(thread)){
+                switch (event.type){
+                    case TraceEventType::send:
+                        communicator.send(sends[thread][nextSend++]);
+                        break;
+                    case TraceEventType::recvAll:
+                        data.clear();
+                        communicator.recvAll(data);
+                        nbThreadReceived += data.size();
+                        nbThreadRecvAll++;
+                        break;
+                    case TraceEventType::recv:
+                        if (communicator.recv(one)) nbThreadReceived++;
+                        break;
+                    default: //The positions depend on the communicator
+                        break;
+                }
+            }
+            seconds[thread] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            nbRecvAll += nbThreadRecvAll;
+            nbReceived += nbThreadReceived;
+            return 0;
+        });
+    }
+    group.start();
+    group.wait();
+    ReplayStatistics ret;
+    ret.seconds = seconds.empty() ? 0 : *std::max_element(seconds.begin(), seconds.end()); //A trace may have no thread
+    ret.nbSend = 0;
+    for (const std::vector<T>& threadSends : sends) ret.nbSend += threadSends.size();
+    ret.nbRecvAll = nbRecvAll;
+    ret.nbReceived = nbReceived;
+    return ret;
+}
+
+} // namespace pFactory
+
+#endif
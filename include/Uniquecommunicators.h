@@ -0,0 +1,218 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef uniquecommunicators_H
+#define uniquecommunicators_H
+
+#include <atomic>
+#include <cstdint>
+#include "Communicators.h"
+
+namespace pFactory
+{
+
+/*
+ * A concurrent Bloom filter with two generations to bound its memory (lock-free except when a generation is replaced).
+ * A key is present if it is in the current or in the previous generation. When the current generation is full,
+ * the previous one is cleared and becomes the current one: old keys are forgotten.
+ * The bits of a key are in the same word (a blocked Bloom filter): a single fetch_or inserts it, so when several
+ * threads insert the same key at the same time, only one of them sees it as new.
+ * As any Bloom filter, a key can be wrongly considered present (false positive).
+ */
+class AgingBloomFilter
+{
+private:
+    static const unsigned int nbHashes = 4; /* Number of bits per key */
+
+    const uint64_t mask; /* Number of bits of a generation - 1 */
+    const unsigned int maxKeys; /* Number of keys inserted in a generation before replacing it */
+
+    std::vector<std::atomic<uint64_t>> generations[2];
+    std::atomic<unsigned int> current; /* Index of the current generation */
+    std::atomic<unsigned int> nbKeys; /* Number of keys inserted in the current generation */
+    std::mutex agingMutex;
+
+    /* The word of a key */
+    inline uint64_t word(uint64_t hash) const {return (hash ^ (hash >> 32)) & (mask >> 6);}
+
+    /* The bits of a key in its word */
+    inline uint64_t bits(uint64_t hash) const {
+        const uint64_t hash2 = hash * 0x9E3779B97F4A7C15ULL;
+        uint64_t ret = 0;
+        for (unsigned int i = 0; i < nbHashes; i++) ret |= 1ULL << ((hash2 >> (40 + 6 * i)) & 63);
+        return ret;
+    }
+
+    inline bool contains(const std::vector<std::atomic<uint64_t>>& generation, uint64_t hash) const {
+        const uint64_t b = bits(hash);
+        return (generation[word(hash)].load(std::memory_order_relaxed) & b) == b;
+    }
+
+    /* Replace the previous generation by an empty current one */
+    inline void age(unsigned int generation){
+        std::unique_lock<std::mutex> lock(agingMutex, std::try_to_lock);
+        if (!lock.owns_lock() || current.load() != generation) return; //Another thread is aging the filter
+        std::vector<std::atomic<uint64_t>>& previous = generations[1 - generation];
+        for (auto& word : previous) word.store(0, std::memory_order_relaxed);
+        nbKeys.store(0);
+        current.store(1 - generation);
+    }
+
+public:
+    /* The bits set by an insertion (see cancel()) */
+    struct Insertion
+    {
+        unsigned int generation;
+        uint64_t word;
+        uint64_t bits;
+    };
+
+    /* \param logNbBits The number of bits of a generation is 2^logNbBits (two generations are allocated)
+       \param pmaxKeys The number of keys of a generation (0 to choose it according to the number of bits)
+    */
+    explicit AgingBloomFilter(unsigned int logNbBits = 20, unsigned int pmaxKeys = 0):
+        mask((1ULL << std::max(logNbBits, 6u)) - 1),
+        maxKeys(pmaxKeys ? pmaxKeys : (unsigned int)((mask + 1) / (2 * nbHashes))),
+        current(0),
+        nbKeys(0)
+    {
+        generations[0] = std::vector<std::atomic<uint64_t>>((mask + 1) / 64);
+        generations[1] = std::vector<std::atomic<uint64_t>>((mask + 1) / 64);
+    }
+
+    /* Insert a key
+       \param insertion The bits set by this insertion (to cancel it)
+       \return false if the key was already present, true otherwise
+    */
+    inline bool insert(uint64_t hash, Insertion& insertion){
+        insertion.generation = current.load();
+        insertion.word = word(hash);
+        const uint64_t b = bits(hash);
+        insertion.bits = b & ~generations[insertion.generation][insertion.word].fetch_or(b, std::memory_order_relaxed);
+        if (!insertion.bits) return false;
+        //Present in the previous generation: now refreshed in the current one
+        if (contains(generations[1 - insertion.generation], hash)){
+            insertion.bits = 0;
+            return false;
+        }
+        if (nbKeys.fetch_add(1, std::memory_order_relaxed) + 1 >= maxKeys) age(insertion.generation);
+        return true;
+    }
+
+    inline bool insert(uint64_t hash){
+        Insertion insertion;
+        return insert(hash, insertion);
+    }
+
+    /* Cancel an insertion: clear the bits it has set (the keys that share some of these bits may be forgotten) */
+    inline void cancel(const Insertion& insertion){
+        if (insertion.bits) generations[insertion.generation][insertion.word].fetch_and(~insertion.bits, std::memory_order_relaxed);
+    }
+
+    inline bool contains(uint64_t hash) const {
+        return contains(generations[0], hash) || contains(generations[1], hash);
+    }
+};
+
+/*
+ * A communicator that drops duplicates globally: a data already sent by a thread of the group (after normalization) is not sent again.
+ * Receivers get each distinct data once (useful to share clauses learnt by several threads).
+ * Duplicates are detected thanks to an AgingBloomFilter on the hash of the normalized data:
+ * the memory is bounded, old data can be sent again and, rarely, a new data is dropped (false positive).
+ * The hash of a data is inserted in the filter before it is sent: when several threads send the same data at the
+ * same time, only one of them sends it. The insertion is cancelled if the data is not sent (throttled, dropped by the
+ * overflow policy, full queue): it can be sent again.
+ * send() and trySend() are virtual: the duplicates are also dropped through a Communicator<T>&.
+ */
+template <class T>
+class UniqueCommunicator : public Communicator<T>
+{
+    private:
+        std::function<uint64_t(const T&)> hash; /* Hash of a normalized data */
+        std::function<void(T&)> normalize; /* To canonicalize a data before its hash (e.g. sort literals), can be empty */
+        AgingBloomFilter filter;
+        std::vector<std::atomic<unsigned int>> nbDuplicates; /* Per sender (only incremented by the sender) */
+
+        /* Normalize a data and insert its hash in the filter
+           \param insertion To cancel the insertion if the data is not sent
+           \return false if the data has already been sent (or is being sent by another thread)
+        */
+        inline bool insert(T& data, AgingBloomFilter::Insertion& insertion)
+        {
+            if (normalize) normalize(data);
+            if (filter.insert(hash(data), insertion)) return true;
+            nbDuplicates[this->getThreadId()].fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+    public:
+        /* \param g Group of threads
+           \param phash Hash function of a normalized data
+           \param pnormalize Function to canonicalize a data before its hash (the normalized data is sent)
+           \param logNbBits Size of the filter (two generations of 2^logNbBits bits)
+        */
+        UniqueCommunicator(Group& g, const std::function<uint64_t(const T&)>& phash, const std::function<void(T&)>& pnormalize = nullptr, unsigned int logNbBits = 20)
+            : Communicator<T>::Communicator(g),
+            hash(phash),
+            normalize(pnormalize),
+            filter(logNbBits),
+            nbDuplicates(g.getNbThreads())
+        {
+            for (std::atomic<unsigned int>& nb : nbDuplicates) nb = 0;
+        }
+
+        /* Send a data to others threads if no thread has already sent it
+          \param data Data to send
+          \return false if the data is not sent (duplicate or see Communicator<T>::send()), true otherwise
+        */
+        inline bool send(T data) override
+        {
+            const unsigned int threadId = this->getThreadId();
+            if (this->senders[threadId] == false) return false;
+            AgingBloomFilter::Insertion insertion;
+            if (!insert(data, insertion)) return false;
+            if (Communicator<T>::send(data)) return true;
+            filter.cancel(insertion);
+            return false;
+        }
+
+        /* Same as Communicator<T>::trySend(), a duplicate is not sent
+          \return false if the data is not sent (queue full, duplicate or this thread is not a sender), true otherwise
+        */
+        inline bool trySend(T data) override
+        {
+            const unsigned int threadId = this->getThreadId();
+            if (this->senders[threadId] == false) return false;
+            AgingBloomFilter::Insertion insertion;
+            if (!insert(data, insertion)) return false;
+            if (Communicator<T>::trySend(data)) return true;
+            filter.cancel(insertion);
+            return false;
+        }
+
+        inline unsigned int getNbDuplicates()
+        {
+            unsigned int ret = 0;
+            for (unsigned int threadId = 0; threadId < this->nbThreads; threadId++)
+                ret += nbDuplicates[threadId].load(std::memory_order_relaxed);
+            return ret;
+        }
+};
+
+} // namespace pFactory
+
+#endif
@@ -9,8 +9,25 @@
 #include "Controller.h"
 #include "Groups.h"
 #include "Barrier.h"
+#include "Collectives.h"
+#include "Phasers.h"
+#include "Concurrentqueues.h"
+#include "Topologies.h"
+#include "Metrics.h"
+#include "Traces.h"
 #include "Communicators.h"
 #include "Intercommunicators.h"
+#include "Uniquecommunicators.h"
+#include "Hierarchicalcommunicators.h"
+#include "Codecs.h"
+#include "Channelcommunicators.h"
+#include "Deterministiccommunicators.h"
+#include "Arenacommunicators.h"
+#include "Sharedmemories.h"
+#include "Processcommunicators.h"
+#include "Processgroups.h"
+#include "Boundregisters.h"
+#include "Eventcounts.h"
 #include "Safestd.h"
 
 
@@ -20,6 +37,9 @@ namespace pFactory{
         
     unsigned int getNbCores();
 
+    /* A queue under a mutex (see BoundedQueue, MpscQueue and SpscQueue in Concurrentqueues.h for concurrent queues
+     * with try_pop() and waits)
+     */
     template<class T=int>
     class SafeQueue {
         public:
@@ -32,9 +52,9 @@ namespace pFactory{
             };
 
             /* Calling this function on an empty container causes undefined behavior. */
-            inline T &pop_back() {
+            inline T pop_back() {
                 mutex.lock();
-                T &ele = queue.back();
+                T ele = std::move(queue.back());
                 queue.pop_back();
                 mutex.unlock();
                 return ele;
@@ -0,0 +1,57 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <climits>
+#include <thread>
+
+#include "Collectives.h"
+
+namespace pFactory{
+
+    Collectives::Collectives(unsigned int pnbThreads):
+        nbThreads(pnbThreads),
+        nbSpins(pnbThreads <= std::thread::hardware_concurrency() ? 4096 : 0),
+        slots(pnbThreads),
+        parents(pnbThreads, UINT_MAX),
+        children(pnbThreads)
+    {
+        reset();
+        if (nbThreads) build(0, nbThreads);
+    }
+
+    void Collectives::reset(){
+        for (Slot& slot : slots){
+            slot.up = 0;
+            slot.down = 0;
+            slot.nbOperations = 0;
+        }
+    }
+
+    void Collectives::build(unsigned int first, unsigned int end){
+        //The other threads of the range are split in at most arity consecutive ranges of the same size
+        unsigned int start = first + 1;
+        for (unsigned int i = 0; i < arity && start < end; i++){
+            const unsigned int size = (end - start + (arity - i) - 1) / (arity - i);
+            children[first].push_back(start);
+            parents[start] = first;
+            build(start, start + size);
+            start += size;
+        }
+    }
+
+}
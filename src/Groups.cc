@@ -20,6 +20,7 @@
 #include <mutex>
 #include <chrono>
 #include <thread>
+#include <pthread.h>
 
 #include "Groups.h"
 #include "Controller.h"
@@ -27,6 +28,36 @@
 namespace pFactory{
     unsigned int Group::groupCount = 0;
 
+    /* Scan the cores of each NUMA node of the machine (one node with all cores if this information is not available) */
+    static std::vector<std::vector<unsigned int>> scanNumaNodes(){
+        std::vector<std::vector<unsigned int>> nodes;
+        for (unsigned int node = 0;; node++){
+            std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!cpulist) break;
+            std::vector<unsigned int> cores;
+            std::string range;
+            while (std::getline(cpulist, range, ',')){ //Format: 0-19,40-59
+                unsigned int first = 0, last = 0;
+                int nb = sscanf(range.c_str(), "%u-%u", &first, &last);
+                if (nb < 1) continue;
+                if (nb == 1) last = first;
+                for (unsigned int core = first; core <= last; core++) cores.push_back(core);
+            }
+            if (!cores.empty()) nodes.push_back(cores);
+        }
+        if (nodes.empty()){
+            nodes.push_back(std::vector<unsigned int>());
+            for (unsigned int core = 0; core < std::max(1u, std::thread::hardware_concurrency()); core++) nodes[0].push_back(core);
+        }
+        return nodes;
+    }
+
+    /* The cores of each NUMA node of the machine (scanned once) */
+    static const std::vector<std::vector<unsigned int>>& readNumaNodes(){
+        static const std::vector<std::vector<unsigned int>> nodes = scanNumaNodes();
+        return nodes;
+    }
+
     Group::Group(unsigned int pnbThreads):
         barrier(pnbThreads),
         winnerId(UINT_MAX),
@@ -39,12 +70,20 @@ namespace pFactory{
         concurrentMode(false),
 	    startedBarrier(NULL),
 	    waitingThreads(NULL),
+	    waitingCancelled(false),
         hasStarted(false),
         hasWaited(false),
         concurrentGroupsModes(false),
         taskPopFront(false),
-        controller(NULL)
+        controller(NULL),
+        threadNumaNodes(pnbThreads, 0),
+        nbNumaNodes(1),
+        collectives(pnbThreads)
     {
+        //Spread blocks of consecutive threads on the NUMA nodes
+        unsigned int nbNodes = std::min((unsigned int)readNumaNodes().size(), pnbThreads);
+        for (unsigned int i = 0; i < pnbThreads; i++) threadNumaNodes[i] = i * nbNodes / pnbThreads;
+        if (nbNodes > 0) nbNumaNodes = nbNodes;
         startedBarrier = new Barrier(pnbThreads+1);
         for (unsigned int i = 0;i<pnbThreads;i++)threads.push_back(new std::thread(&Group::wrapperFunction,this));
         if(VERBOSE)
@@ -57,6 +96,26 @@ namespace pFactory{
 
 
     
+    Group& Group::setNumaNodes(const std::vector<unsigned int>& pthreadNumaNodes){
+        assert(pthreadNumaNodes.size() == nbThreads);
+        threadNumaNodes = pthreadNumaNodes;
+        nbNumaNodes = 0;
+        for (unsigned int node : threadNumaNodes) nbNumaNodes = std::max(nbNumaNodes, node + 1);
+        return *this;
+    }
+
+    Group& Group::bindNumaNodes(){
+        const std::vector<std::vector<unsigned int>>& nodes = readNumaNodes();
+        for (unsigned int i = 0; i < nbThreads; i++){
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            for (unsigned int core : nodes[threadNumaNodes[i] % nodes.size()]) CPU_SET(core, &cpuset);
+            if (pthread_setaffinity_np(threads[i]->native_handle(), sizeof(cpu_set_t), &cpuset) != 0 && VERBOSE)
+                printf("c [pFactory][Group N°%d] Thread N°%d can not be bound to the NUMA node %d.\n", idGroup, i, threadNumaNodes[i]);
+        }
+        return *this;
+    }
+
     void Group::reload(){
         if (!hasStarted or !hasWaited){
             tasksIdToRun.clear(); //First clean all tasks
@@ -70,9 +129,21 @@ namespace pFactory{
         hasStarted=false;
         hasWaited=false;
         winnerId = UINT_MAX;
+        //The tasks of the previous run
+        tasksIdToRun.clear();
+        tasks.clear();
+        nbTasks = 0;
         //The barrier
         delete startedBarrier;
         startedBarrier = new Barrier(nbThreads+1);
+        //The collective operations of the previous run
+        collectives.reset();
+        //The threads of the previous run are joined: create new ones
+        stopWaitingThread();
+        for (unsigned int i = 0; i < nbThreads; i++){
+            delete threads[i];
+            threads[i] = new std::thread(&Group::wrapperFunction,this);
+        }
     }
     
 
@@ -118,8 +189,21 @@ namespace pFactory{
     }
 
     void Group::wrapperWaitting(unsigned int seconds){
-        std::this_thread::sleep_for(std::chrono::seconds(seconds));
-        stop();
+        std::unique_lock<std::mutex> lock(waitingMutex);
+        if (!waitingCondition.wait_for(lock, std::chrono::seconds(seconds), [this]{return waitingCancelled;})) stop();
+    }
+
+    void Group::stopWaitingThread(){
+        if (waitingThreads == NULL) return;
+        {
+            std::unique_lock<std::mutex> lock(waitingMutex);
+            waitingCancelled = true;
+        }
+        waitingCondition.notify_one();
+        waitingThreads->join();
+        delete waitingThreads;
+        waitingThreads = NULL;
+        waitingCancelled = false;
     }
     
     int Group::wait(unsigned int seconds){
@@ -133,14 +217,35 @@ namespace pFactory{
     }
 
     int Group::waitAndKill(unsigned int seconds){
+        stopWaitingThread();
         waitingThreads=new std::thread(&Group::wrapperWaitting,this,seconds);
-        return wait();
+        const int ret = wait();
+        stopWaitingThread(); //The tasks may end before the timeout: its stop() must not reach the next run
+        return ret;
     }
 
 
+    unsigned int Group::addTaskListener(const std::function<void(unsigned int)>& onStart, const std::function<void(unsigned int)>& onEnd){
+        taskListeners.push_back(std::make_pair(onStart, onEnd));
+        return taskListeners.size() - 1;
+    }
+
+    void Group::removeTaskListener(unsigned int listenerId){
+        //Keep the identifiers of the other listeners
+        taskListeners[listenerId] = std::make_pair(std::function<void(unsigned int)>(), std::function<void(unsigned int)>());
+    }
+
+    void Group::notifyTaskListeners(bool start){
+        for (auto& listener: taskListeners){
+            const std::function<void(unsigned int)>& function = start ? listener.first : listener.second;
+            if (function) function(getThreadId());
+        }
+    }
+
     void Group::wrapperFunction(){
         //Create a wrapper unique lock for the mutex 
         std::unique_lock<std::mutex> tasksLock(tasksMutex,std::defer_lock);
+        currentGroup() = this;
         // wait that the user calls start() para:
         startedBarrier->wait();
         //Take a task
@@ -148,6 +253,8 @@ namespace pFactory{
             tasksLock.lock();
             //if there are no more tasks
             if(!tasksIdToRun.size() || testStop){
+                tasksLock.unlock();
+                notifyTaskListeners(false);
                 return;
             }
             
@@ -171,7 +278,9 @@ namespace pFactory{
             //Launch a task  
             if(VERBOSE)
                 printf("c [pFactory][Group N°%d] task %d launched on thread %d.\n",getId(),getTaskId(),getThreadId());
+            notifyTaskListeners(true);
             int returnCode = function();  
+            notifyTaskListeners(false);
             
             tasksLock.lock();
             tasks[taskId].setStatus(pFactory::Status::terminated);
@@ -191,6 +300,8 @@ namespace pFactory{
                 }
                 if(VERBOSE)
                     printf("c [pFactory][Group N°%d] concurent mode: thread %d has won with the task %d.\n",getId(),getThreadId(),getTaskId());
+                tasksLock.unlock();
+                notifyTaskListeners(false);
                 return;
 
             }
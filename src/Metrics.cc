@@ -0,0 +1,79 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Metrics.h"
+
+namespace pFactory{
+
+    CommunicatorMetrics::CommunicatorMetrics(unsigned int pnbThreads):
+        nbThreads(pnbThreads),
+        nbData(pnbThreads, std::vector<uint64_t>(pnbThreads, 0)),
+        nbBytes(pnbThreads, std::vector<uint64_t>(pnbThreads, 0)),
+        queueDepth(pnbThreads, 0),
+        queueHighWater(pnbThreads, 0),
+        lockWait(pnbThreads, 0),
+        latencies(pnbThreads, std::vector<uint64_t>(nbBuckets, 0))
+    {}
+
+    uint64_t CommunicatorMetrics::getNbData() const{
+        uint64_t ret = 0;
+        for (const std::vector<uint64_t>& row : nbData) for (uint64_t nb : row) ret += nb;
+        return ret;
+    }
+
+    uint64_t CommunicatorMetrics::getNbBytes() const{
+        uint64_t ret = 0;
+        for (const std::vector<uint64_t>& row : nbBytes) for (uint64_t nb : row) ret += nb;
+        return ret;
+    }
+
+    uint64_t CommunicatorMetrics::getNbSamples() const{
+        uint64_t ret = 0;
+        for (const std::vector<uint64_t>& histogram : latencies) for (uint64_t nb : histogram) ret += nb;
+        return ret;
+    }
+
+    uint64_t CommunicatorMetrics::getLatencyPercentile(double percentile) const{
+        const uint64_t nbSamples = getNbSamples();
+        if (nbSamples == 0) return 0;
+        uint64_t rank = (uint64_t)(percentile * nbSamples), nb = 0;
+        if (rank >= nbSamples) rank = nbSamples - 1;
+        for (unsigned int b = 0; b < nbBuckets; b++){
+            for (const std::vector<uint64_t>& histogram : latencies) nb += histogram[b];
+            if (nb > rank) return (b == nbBuckets - 1) ? UINT64_MAX : ((uint64_t)2 << b);
+        }
+        return UINT64_MAX;
+    }
+
+    std::ostream& operator<<(std::ostream& os, const CommunicatorMetrics& metrics){
+        for (unsigned int i = 0; i < metrics.nbThreads; i++){
+            uint64_t nbData = 0, nbBytes = 0;
+            for (unsigned int j = 0; j < metrics.nbThreads; j++){
+                nbData += metrics.nbData[i][j];
+                nbBytes += metrics.nbBytes[i][j];
+            }
+            if (nbData == 0 && metrics.queueHighWater[i] == 0 && metrics.lockWait[i] == 0) continue;
+            os << "c [pFactory][Communicator] thread " << i << ": data received " << nbData << " times (" << nbBytes << " bytes)"
+               << " - queue: " << metrics.queueDepth[i] << " (high-water: " << metrics.queueHighWater[i] << ")"
+               << " - lock wait: " << metrics.lockWait[i] / 1000 << "us" << std::endl;
+        }
+        os << "c [pFactory][Communicator] latency (" << metrics.getNbSamples() << " samples): median < "
+           << metrics.getLatencyPercentile(0.5) / 1000.0 << "us - 99th < " << metrics.getLatencyPercentile(0.99) / 1000.0 << "us" << std::endl;
+        return os;
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <thread>
+
+#include "Phasers.h"
+
+namespace pFactory{
+
+    Phaser::Phaser(unsigned int pnbParties):
+        state(makeState(0, pnbParties, pnbParties)),
+        nbSpins(4096),
+        group(NULL),
+        listenerId(0),
+        autoRegister(false),
+        nbReserved(0),
+        reserved(true)
+    {
+        assert(pnbParties <= 0xFFFF);
+    }
+
+    Phaser::Phaser(Group& g, bool pautoRegister):
+        state(makeState(0, 0, 0)),
+        nbSpins(g.getNbThreads() <= std::thread::hardware_concurrency() ? 4096 : 0),
+        group(&g),
+        autoRegister(pautoRegister),
+        registeredThreads(g.getNbThreads(), 0),
+        lastArrivals(g.getNbThreads(), -1),
+        nbReserved(0),
+        reserved(!pautoRegister)
+    {
+        listenerId = g.addTaskListener([this](unsigned int threadId){onStart(threadId);}, [this](unsigned int threadId){onEnd(threadId);});
+    }
+
+    Phaser::~Phaser(){
+        if (group) group->removeTaskListener(listenerId);
+    }
+
+    int Phaser::addParties(unsigned int nb){
+        uint64_t s = state.load(std::memory_order_relaxed);
+        while (true){
+            assert(partiesOf(s) + nb <= 0xFFFF);
+            const uint64_t next = makeState(phaseOf(s), partiesOf(s) + nb, unarrivedOf(s) + nb);
+            if (state.compare_exchange_weak(s, next, std::memory_order_acq_rel, std::memory_order_relaxed)) return phaseOf(s);
+        }
+    }
+
+    int Phaser::registerParty(){
+        if (group && Group::getCurrentGroup() == group){
+            std::unique_lock<std::mutex> lock(registrationMutex);
+            const unsigned int threadId = group->getThreadId();
+            assert(!registeredThreads[threadId]); //A task is at most one party
+            registeredThreads[threadId] = 1;
+        }
+        return addParties(1);
+    }
+
+    int Phaser::arriveAndDeregister(){
+        if (group && Group::getCurrentGroup() == group){
+            std::unique_lock<std::mutex> lock(registrationMutex);
+            registeredThreads[group->getThreadId()] = 0;
+        }
+        return arrive(true);
+    }
+
+    void Phaser::deregister(unsigned int threadId){
+        uint64_t s = state.load(std::memory_order_relaxed);
+        while (true){
+            if (phaseOf(s) != lastArrivals[threadId]){ //Not arrived at the current phase
+                arrive(true);
+                return;
+            }
+            //Already arrived: the party is only removed from the next phases
+            const uint64_t next = makeState(phaseOf(s), partiesOf(s) - 1, unarrivedOf(s));
+            if (state.compare_exchange_weak(s, next, std::memory_order_acq_rel, std::memory_order_relaxed)) return;
+        }
+    }
+
+    void Phaser::onStart(unsigned int threadId){
+        if (!autoRegister) return;
+        std::unique_lock<std::mutex> lock(registrationMutex);
+        if (!reserved){ //The first task: the tasks started with the group are registered at once
+            reserved = true;
+            nbReserved = std::min((unsigned int)group->getNbTasks(), group->getNbThreads());
+            addParties(nbReserved);
+        }
+        registeredThreads[threadId] = 1;
+        if (nbReserved) nbReserved--;
+        else addParties(1);
+    }
+
+    void Phaser::onEnd(unsigned int threadId){
+        std::unique_lock<std::mutex> lock(registrationMutex);
+        if (!registeredThreads[threadId]) return;
+        registeredThreads[threadId] = 0;
+        deregister(threadId);
+    }
+
+}
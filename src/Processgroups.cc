@@ -0,0 +1,310 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <chrono>
+#include <csignal>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "Groups.h"
+#include "Processgroups.h"
+
+namespace pFactory{
+
+    unsigned int ProcessGroup::groupCount = 0;
+
+    /* Sleep while a shared word has a value (a futex shared between processes, a short sleep elsewhere) */
+    static void sharedWait(std::atomic<uint32_t>& word, uint32_t value, unsigned int milliseconds){
+        if (word.load(std::memory_order_acquire) != value) return;
+#ifdef __linux__
+        struct timespec ts;
+        ts.tv_sec = milliseconds / 1000;
+        ts.tv_nsec = (milliseconds % 1000) * 1000000L;
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, &ts, NULL, 0);
+#else
+        (void)milliseconds;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+#endif
+    }
+
+    static void sharedWake(std::atomic<uint32_t>& word){
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+        (void)word;
+#endif
+    }
+
+    ProcessGroup::ProcessGroup(unsigned int pnbWorkers, std::size_t pmemoryLimit, std::size_t pmessageSize):
+        idGroup(ProcessGroup::groupCount++),
+        nbWorkers(pnbWorkers),
+        memoryLimit(pmemoryLimit),
+        messageSize(pmessageSize),
+        slotSize((sizeof(Slot) + 2 * pmessageSize + 63) / 64 * 64),
+        memory(64 + pnbWorkers * slotSize),
+        pids(pnbWorkers, 0),
+        workerTasks(pnbWorkers, UINT_MAX),
+        workerId(UINT_MAX),
+        parentPid(getpid()),
+        killing(false),
+        nextTask(0),
+        winnerId(UINT_MAX),
+        nbCrashes(0),
+        concurrentMode(false),
+        forked(false),
+        hasStarted(false),
+        hasWaited(false),
+        dispatcher(NULL)
+    {
+        if(VERBOSE)
+            printf("c [pFactory][ProcessGroup N°%d] created (workers:%d).\n",idGroup,nbWorkers);
+    }
+
+    ProcessGroup::~ProcessGroup(){
+        if (hasStarted && !hasWaited) wait();
+        //Stop the workers
+        for (unsigned int i = 0; i < nbWorkers; i++){
+            if (pids[i] <= 0) continue;
+            slot(i)->state.store(exiting, std::memory_order_release);
+            sharedWake(slot(i)->state);
+        }
+        for (unsigned int i = 0; i < nbWorkers; i++)
+            if (pids[i] > 0) waitpid(pids[i], NULL, 0);
+    }
+
+    unsigned int ProcessGroup::registerFunction(const std::function<int(const std::string&)>& function){
+        assert(!forked);
+        functions.push_back(function);
+        return functions.size() - 1;
+    }
+
+    void ProcessGroup::add(unsigned int functionId, const std::string& argument){
+        assert(functionId < functions.size() && argument.size() <= messageSize);
+        tasks.push_back(Task(tasks.size(), std::function<int()>()));
+        taskFunctions.push_back(functionId);
+        taskArguments.push_back(argument);
+        results.push_back(std::string());
+        if(VERBOSE)
+            printf("c [pFactory][ProcessGroup N°%d] new task added (workers:%d - tasks:%d).\n",idGroup,nbWorkers,(int)getNbTasks());
+    }
+
+    void ProcessGroup::fork(unsigned int worker){
+        fflush(stdout); //Else the buffered outputs are written by the parent and the worker
+        const pid_t pid = ::fork();
+        if (pid < 0){
+            perror("c [pFactory][ProcessGroup] fork");
+            return;
+        }
+        if (pid > 0){
+            pids[worker] = pid;
+            return;
+        }
+        //The worker
+        if (memoryLimit){
+            struct rlimit limit;
+            limit.rlim_cur = limit.rlim_max = memoryLimit;
+            setrlimit(RLIMIT_AS, &limit);
+        }
+        workerId = worker;
+        workerLoop();
+        fflush(stdout);
+        _exit(0);
+    }
+
+    void ProcessGroup::workerLoop(){
+        Slot* s = slot(workerId);
+        while (true){
+            const uint32_t state = s->state.load(std::memory_order_acquire);
+            if (state == exiting || getppid() != parentPid) return; //Also ends with the parent process
+            if (state != assigned){
+                sharedWait(s->state, state, 1000);
+                continue;
+            }
+            s->state.store(running, std::memory_order_relaxed);
+            s->resultSize = 0;
+            const std::string taskArgument(argument(workerId), s->argumentSize);
+            s->returnCode = functions[s->functionId](taskArgument);
+            s->state.store(done, std::memory_order_release);
+            control()->events.fetch_add(1, std::memory_order_release);
+            sharedWake(control()->events);
+        }
+    }
+
+    void ProcessGroup::setResult(const std::string& result){
+        assert(workerId != UINT_MAX); //Only in a task
+        Slot* s = slot(workerId);
+        s->resultSize = std::min(result.size(), messageSize);
+        memcpy(this->result(workerId), result.data(), s->resultSize);
+    }
+
+    void ProcessGroup::stop(){
+        control()->stop.store(1, std::memory_order_release);
+        control()->events.fetch_add(1, std::memory_order_release);
+        sharedWake(control()->events);
+    }
+
+    bool ProcessGroup::isStopped() const {return control()->stop.load(std::memory_order_acquire) != 0;}
+
+    /* Read the end of the task of a worker
+       \return true if the worker is free
+    */
+    bool ProcessGroup::collect(unsigned int worker){
+        Slot* s = slot(worker);
+        if (workerTasks[worker] == UINT_MAX) return true;
+        if (s->state.load(std::memory_order_acquire) != done) return false;
+        Task& task = tasks[workerTasks[worker]];
+        task.setReturnCode(s->returnCode);
+        task.setStatus(Status::terminated);
+        results[task.getId()] = std::string(result(worker), s->resultSize);
+        if (concurrentMode && winnerId == UINT_MAX){
+            winnerId = task.getId();
+            stop();
+            if(VERBOSE)
+                printf("c [pFactory][ProcessGroup N°%d] concurent mode: worker %d has won with the task %d.\n",idGroup,worker,task.getId());
+        }
+        workerTasks[worker] = UINT_MAX;
+        s->state.store(idle, std::memory_order_relaxed);
+        return true;
+    }
+
+    /* A worker has died: its task is failed, a new worker replaces it */
+    void ProcessGroup::fail(unsigned int worker, int status){
+        pids[worker] = 0;
+        if (!collect(worker)){ //Died during its task
+            Task& task = tasks[workerTasks[worker]];
+            task.setStatus(Status::failed);
+            task.setReturnCode(WIFSIGNALED(status) ? -WTERMSIG(status) : WEXITSTATUS(status));
+            nbCrashes++;
+            if(VERBOSE)
+                printf("c [pFactory][ProcessGroup N°%d] worker %d has crashed during the task %d (%s).\n",idGroup,worker,task.getId(),
+                    WIFSIGNALED(status) ? strsignal(WTERMSIG(status)) : "exit");
+            workerTasks[worker] = UINT_MAX;
+        }
+        slot(worker)->state.store(idle, std::memory_order_relaxed);
+        fork(worker);
+    }
+
+    void ProcessGroup::dispatch(){
+        Control* c = control();
+        while (true){
+            const uint32_t events = c->events.load(std::memory_order_acquire);
+            //Kill the workers that run a task (see kill())
+            if (killing.exchange(false)){
+                for (unsigned int i = 0; i < nbWorkers; i++)
+                    if (pids[i] > 0 && workerTasks[i] != UINT_MAX) ::kill(pids[i], SIGKILL);
+            }
+            //The dead workers
+            int status;
+            for (unsigned int i = 0; i < nbWorkers; i++)
+                if (pids[i] > 0 && waitpid(pids[i], &status, WNOHANG) == pids[i]) fail(i, status);
+            //The ended tasks and the new ones
+            unsigned int nbRunning = 0;
+            for (unsigned int i = 0; i < nbWorkers; i++){
+                if (!collect(i)){
+                    nbRunning++;
+                    continue;
+                }
+                if (nextTask >= tasks.size() || isStopped() || pids[i] <= 0) continue;
+                Task& task = tasks[nextTask++];
+                Slot* s = slot(i);
+                s->functionId = taskFunctions[task.getId()];
+                s->argumentSize = taskArguments[task.getId()].size();
+                memcpy(argument(i), taskArguments[task.getId()].data(), s->argumentSize);
+                task.setStatus(Status::inProgress);
+                task.setThreadId(i);
+                workerTasks[i] = task.getId();
+                s->state.store(assigned, std::memory_order_release);
+                sharedWake(s->state);
+                nbRunning++;
+                if(VERBOSE)
+                    printf("c [pFactory][ProcessGroup N°%d] task %d launched on worker %d.\n",idGroup,task.getId(),i);
+            }
+            if (nbRunning == 0 && (nextTask >= tasks.size() || isStopped())) return;
+            //No worker alive (every fork has failed): the remaining tasks are failed
+            if (nbRunning == 0 && std::none_of(pids.begin(), pids.end(), [](pid_t pid){return pid > 0;})){
+                for (; nextTask < tasks.size(); nextTask++){
+                    tasks[nextTask].setStatus(Status::failed);
+                    tasks[nextTask].setReturnCode(-1);
+                }
+                if(VERBOSE)
+                    printf("c [pFactory][ProcessGroup N°%d] no worker can be forked: the remaining tasks are failed.\n",idGroup);
+                return;
+            }
+            //Sleep until the end of a task (and check the dead workers at least every 10ms)
+            sharedWait(c->events, events, 10);
+        }
+    }
+
+    void ProcessGroup::start(){
+        if(VERBOSE) {
+            printf("c [pFactory][ProcessGroup N°%d] concurrent mode: %s.\n", idGroup, concurrentMode ? "enabled" : "disabled");
+            printf("c [pFactory][ProcessGroup N°%d] computations in progress (workers:%d - tasks:%d).\n", idGroup, nbWorkers, (int)getNbTasks());
+        }
+        //The first start forks the workers, the next ones fork again those that could not be replaced
+        for (unsigned int i = 0; i < nbWorkers; i++)
+            if (pids[i] <= 0) fork(i);
+        forked = true;
+        hasStarted = true;
+        dispatcher = new std::thread(&ProcessGroup::dispatch, this);
+    }
+
+    int ProcessGroup::wait(){
+        if (!hasStarted) start();
+        if (!hasWaited){
+            dispatcher->join();
+            delete dispatcher;
+            dispatcher = NULL;
+            hasWaited = true;
+        }
+        if (concurrentMode && winnerId != UINT_MAX){
+            if(VERBOSE)
+                printf("c [pFactory][ProcessGroup N°%d] Return Code of the winner:%d (Worker N°%d)\n",idGroup,getWinner().getReturnCode(),getWinner().getThreadId());
+            return getWinner().getReturnCode();
+        }
+        return 0;
+    }
+
+    int ProcessGroup::kill(){
+        //The dispatcher kills the workers that run a task (and replaces them)
+        killing = true;
+        stop();
+        return wait();
+    }
+
+    void ProcessGroup::reload(){
+        if (hasStarted && !hasWaited) kill();
+        control()->stop.store(0, std::memory_order_release);
+        tasks.clear();
+        taskFunctions.clear();
+        taskArguments.clear();
+        results.clear();
+        nextTask = 0;
+        winnerId = UINT_MAX;
+        nbCrashes = 0;
+        hasStarted = false;
+        hasWaited = false;
+    }
+}
@@ -0,0 +1,139 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Sharedmemories.h"
+
+namespace pFactory{
+
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The shared memory needs lock-free 64-bit atomics (address-free)");
+
+    static void throwError(const std::string& what){
+        throw std::system_error(errno, std::generic_category(), "pFactory shared memory: " + what);
+    }
+
+    SharedMemory::SharedMemory(const std::string& pname, std::size_t psize, unsigned int timeout):
+        name(pname),
+        size(psize),
+        creator(false),
+        memory(MAP_FAILED)
+    {
+        const std::size_t totalSize = headerSize + size;
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd >= 0){
+            creator = true;
+            if (ftruncate(fd, totalSize) != 0){
+                close(fd);
+                shm_unlink(name.c_str());
+                throwError("ftruncate " + name);
+            }
+        }else{
+            if (errno != EEXIST) throwError("shm_open " + name);
+            fd = shm_open(name.c_str(), O_RDWR, 0600);
+            if (fd < 0) throwError("shm_open " + name);
+        }
+        //A joining process waits for the size set by the creator
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+        struct stat status;
+        while (!creator){
+            if (fstat(fd, &status) != 0){
+                close(fd);
+                throwError("fstat " + name);
+            }
+            if ((std::size_t)status.st_size >= totalSize) break;
+            if (std::chrono::steady_clock::now() > deadline){
+                close(fd);
+                errno = ETIMEDOUT;
+                throwError("creator of " + name);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        memory = mmap(NULL, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd); //The mapping keeps the segment
+        if (memory == MAP_FAILED){
+            if (creator) shm_unlink(name.c_str());
+            throwError("mmap " + name);
+        }
+        if (creator){
+            header()->size = size;
+            return;
+        }
+        //Wait for the initialization of the content
+        while (header()->state.load(std::memory_order_acquire) != readyState){
+            if (std::chrono::steady_clock::now() > deadline){
+                munmap(memory, totalSize);
+                errno = ETIMEDOUT;
+                throwError("initialization of " + name);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (header()->size != size){
+            munmap(memory, totalSize);
+            errno = EINVAL;
+            throwError("size of " + name);
+        }
+    }
+
+    SharedMemory::SharedMemory(std::size_t psize):
+        size(psize),
+        creator(true),
+        memory(mmap(NULL, headerSize + psize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0))
+    {
+        if (memory == MAP_FAILED) throwError("mmap");
+        header()->size = size;
+    }
+
+    SharedMemory::~SharedMemory(){
+        munmap(memory, headerSize + size);
+        //The processes that have joined keep their mapping, the next run creates a new segment
+        if (creator && !name.empty()) shm_unlink(name.c_str());
+    }
+
+    void SharedMemory::ready(){
+        header()->state.store(readyState, std::memory_order_release);
+    }
+
+    void SharedMemory::remove(const std::string& name){
+        shm_unlink(name.c_str());
+    }
+
+    uint64_t getProcessStartTime(int pid){
+        //The 22nd field of /proc/pid/stat, after the name of the process (between parentheses, may contain spaces)
+        char path[32];
+        snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+        FILE* file = fopen(path, "r");
+        if (!file) return 0;
+        char buffer[1024];
+        const std::size_t size = fread(buffer, 1, sizeof(buffer) - 1, file);
+        fclose(file);
+        buffer[size] = 0;
+        const char* field = strrchr(buffer, ')');
+        if (!field) return 0;
+        for (unsigned int i = 2; i < 22 && field; i++) field = strchr(field + 1, ' ');
+        return field ? strtoull(field + 1, NULL, 10) : 0;
+    }
+}
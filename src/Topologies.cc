@@ -0,0 +1,91 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include "Topologies.h"
+
+namespace pFactory{
+
+    Topology::Topology(const std::vector<std::vector<unsigned int>>& pneighbors):
+        neighbors(pneighbors),
+        gossipDegree(0),
+        gossipPeriod(0),
+        hubThread(UINT_MAX)
+    {}
+
+    Topology Topology::complete(unsigned int nbThreads){
+        std::vector<std::vector<unsigned int>> neighbors(nbThreads);
+        for (unsigned int i = 0; i < nbThreads; i++)
+            for (unsigned int j = 0; j < nbThreads; j++)
+                if (i != j) neighbors[i].push_back(j);
+        return Topology(neighbors);
+    }
+
+    Topology Topology::ring(unsigned int nbThreads){
+        std::vector<std::vector<unsigned int>> neighbors(nbThreads);
+        for (unsigned int i = 0; i < nbThreads && nbThreads > 1; i++){
+            neighbors[i].push_back((i + nbThreads - 1) % nbThreads);
+            if (nbThreads > 2) neighbors[i].push_back((i + 1) % nbThreads);
+        }
+        return Topology(neighbors);
+    }
+
+    Topology Topology::tree(unsigned int nbThreads, unsigned int arity){
+        std::vector<std::vector<unsigned int>> neighbors(nbThreads);
+        for (unsigned int i = 1; i < nbThreads; i++){
+            unsigned int parent = (i - 1) / arity;
+            neighbors[i].push_back(parent);
+            neighbors[parent].push_back(i);
+        }
+        return Topology(neighbors);
+    }
+
+    Topology Topology::hypercube(unsigned int nbThreads){
+        std::vector<std::vector<unsigned int>> neighbors(nbThreads);
+        for (unsigned int i = 0; i < nbThreads; i++)
+            for (unsigned int bit = 1; bit < nbThreads; bit <<= 1)
+                if ((i ^ bit) < nbThreads) neighbors[i].push_back(i ^ bit);
+        return Topology(neighbors);
+    }
+
+    Topology Topology::gossip(unsigned int nbThreads, unsigned int degree, unsigned int period){
+        //The first neighbors are the next threads, they are re-drawn by the communicator
+        std::vector<std::vector<unsigned int>> neighbors(nbThreads);
+        if (degree > nbThreads - 1) degree = nbThreads - 1;
+        for (unsigned int i = 0; i < nbThreads; i++)
+            for (unsigned int j = 1; j <= degree; j++)
+                neighbors[i].push_back((i + j) % nbThreads);
+        Topology topology(neighbors);
+        topology.gossipDegree = degree;
+        topology.gossipPeriod = period;
+        return topology;
+    }
+
+    Topology Topology::hub(unsigned int nbThreads, unsigned int hubThread){
+        assert(hubThread < nbThreads);
+        std::vector<std::vector<unsigned int>> neighbors(nbThreads);
+        for (unsigned int i = 0; i < nbThreads; i++){
+            if (i == hubThread) continue;
+            neighbors[i].push_back(hubThread);
+            neighbors[hubThread].push_back(i);
+        }
+        Topology topology(neighbors);
+        topology.hubThread = hubThread;
+        return topology;
+    }
+}
@@ -0,0 +1,215 @@
+/**
+ *   pFactory, a generic library for designing parallel solvers.
+ *   Copyright (C) 2019 Artois University and CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Traces.h"
+
+namespace pFactory{
+
+    /* The file: a header then chunks, each chunk is the events of one thread
+       header: magic (8 bytes), version (4 bytes), number of threads (4 bytes)
+       chunk: thread (4 bytes), number of bytes of the events (4 bytes), time of the first event (8 bytes), events
+    */
+    static const uint64_t traceMagic = 0x31454341525446ULL; // "FTRACE1"
+    static const uint32_t traceVersion = 1;
+    static const std::size_t headerSize = 16;
+    static const std::size_t chunkHeaderSize = 16;
+
+    static void throwError(const std::string& what){
+        throw std::system_error(errno, std::generic_category(), "pFactory trace: " + what);
+    }
+
+    TraceRecorder::TraceRecorder(const std::string& path, unsigned int pnbThreads, std::size_t pmaxBytes, std::size_t pbufferSize):
+        nbThreads(pnbThreads),
+        maxBytes(std::max(pmaxBytes, headerSize)),
+        bufferSize(pbufferSize),
+        start(std::chrono::steady_clock::now()),
+        fd(-1),
+        memory(NULL),
+        offset(headerSize),
+        nbLost(0),
+        buffers(pnbThreads)
+    {
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throwError("open " + path);
+        //A sparse file: only the written pages take space
+        if (ftruncate(fd, maxBytes) != 0){
+            const int error = errno;
+            ::close(fd);
+            errno = error;
+            throwError("ftruncate " + path);
+        }
+        void* address = mmap(NULL, maxBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED){
+            const int error = errno;
+            ::close(fd);
+            errno = error;
+            throwError("mmap " + path);
+        }
+        memory = static_cast<uint8_t*>(address);
+        memcpy(memory, &traceMagic, 8);
+        memcpy(memory + 8, &traceVersion, 4);
+        memcpy(memory + 12, &nbThreads, 4);
+        for (Buffer& buffer : buffers){
+            buffer.data.reserve(bufferSize);
+            buffer.base = buffer.last = 0;
+            buffer.nbEvents = buffer.nbChunkEvents = 0;
+        }
+    }
+
+    TraceRecorder::~TraceRecorder(){
+        close();
+    }
+
+    void TraceRecorder::flush(unsigned int thread){
+        Buffer& buffer = buffers[thread];
+        if (!memory || buffer.nbChunkEvents == 0) return;
+        const uint32_t bytes = buffer.data.size();
+        //Reserve the place of the chunk
+        uint64_t position = offset.load();
+        while (position + chunkHeaderSize + bytes <= maxBytes && !offset.compare_exchange_weak(position, position + chunkHeaderSize + bytes));
+        if (position + chunkHeaderSize + bytes > maxBytes) //The trace is full
+            nbLost += buffer.nbChunkEvents;
+        else{
+            uint8_t* chunk = memory + position;
+            const uint32_t threadId = thread;
+            memcpy(chunk, &threadId, 4);
+            memcpy(chunk + 4, &bytes, 4);
+            memcpy(chunk + 8, &buffer.base, 8);
+            memcpy(chunk + chunkHeaderSize, buffer.data.data(), bytes);
+        }
+        buffer.data.clear();
+        buffer.nbChunkEvents = 0;
+    }
+
+    void TraceRecorder::close(){
+        if (!memory) return;
+        for (unsigned int i = 0; i < nbThreads; i++) flush(i);
+        munmap(memory, maxBytes);
+        memory = NULL;
+        if (ftruncate(fd, offset.load()) != 0 && VERBOSE) printf("c [pFactory][TraceRecorder] the trace can not be truncated.\n");
+        ::close(fd);
+    }
+
+    uint64_t TraceRecorder::getNbEvents() const{
+        uint64_t ret = 0;
+        for (const Buffer& buffer : buffers) ret += buffer.nbEvents;
+        return ret;
+    }
+
+    /* Read a varint before end: false if it does not end before end or does not fit in 64 bits */
+    static inline bool getVarint(const uint8_t*& position, const uint8_t* end, uint64_t& value){
+        value = 0;
+        unsigned int shift = 0;
+        uint8_t byte;
+        do{
+            if (position == end || shift > 63) return false;
+            byte = *position++;
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            shift += 7;
+        }while (byte >= 0x80);
+        return true;
+    }
+
+    TraceReader::TraceReader(const std::string& path):
+        nbThreads(0),
+        memory(NULL),
+        size(0)
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throwError("open " + path);
+        struct stat status;
+        if (fstat(fd, &status) != 0){
+            ::close(fd);
+            throwError("fstat " + path);
+        }
+        size = status.st_size;
+        uint64_t magic = 0;
+        uint32_t version = 0;
+        if (size >= headerSize){
+            void* address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address == MAP_FAILED){
+                ::close(fd);
+                throwError("mmap " + path);
+            }
+            memory = static_cast<uint8_t*>(address);
+            memcpy(&magic, memory, 8);
+            memcpy(&version, memory + 8, 4);
+            memcpy(&nbThreads, memory + 12, 4);
+        }
+        ::close(fd);
+        //A corrupted or truncated trace is rejected (the destructor is not called: unmap here)
+        const auto invalid = [&](const std::string& what){
+            if (memory) munmap(memory, size);
+            memory = NULL;
+            errno = EINVAL;
+            throwError(what + " " + path);
+        };
+        if (magic != traceMagic || version != traceVersion) invalid("not a trace");
+        threadEvents.resize(nbThreads);
+        std::size_t position = headerSize;
+        while (position + chunkHeaderSize <= size){
+            uint32_t thread, bytes;
+            int64_t time;
+            memcpy(&thread, memory + position, 4);
+            memcpy(&bytes, memory + position + 4, 4);
+            memcpy(&time, memory + position + 8, 8);
+            if (thread >= nbThreads || bytes > size - position - chunkHeaderSize) invalid("corrupted chunk in");
+            const uint8_t* event = memory + position + chunkHeaderSize;
+            const uint8_t* end = event + bytes;
+            while (event < end){
+                TraceEvent e;
+                uint64_t value;
+                if (*event > (uint8_t)TraceEventType::advance) invalid("corrupted event in");
+                e.type = (TraceEventType)*event++;
+                e.thread = thread;
+                if (!getVarint(event, end, value)) invalid("corrupted event in");
+                time += value;
+                e.timestamp = time;
+                e.sender = 0;
+                e.position = e.count = 0;
+                e.payload = NULL;
+                e.payloadSize = 0;
+                if (e.type == TraceEventType::send){
+                    if (!getVarint(event, end, value) || value > (uint64_t)(end - event)) invalid("corrupted event in");
+                    e.payloadSize = value;
+                    e.payload = event;
+                    event += e.payloadSize;
+                }else if (e.type == TraceEventType::advance){
+                    uint64_t sender;
+                    if (!getVarint(event, end, sender) || !getVarint(event, end, e.position) || !getVarint(event, end, e.count))
+                        invalid("corrupted event in");
+                    e.sender = sender;
+                }
+                threadEvents[thread].push_back(e);
+            }
+            position += chunkHeaderSize + bytes;
+        }
+        for (const std::vector<TraceEvent>& thread : threadEvents) events.insert(events.end(), thread.begin(), thread.end());
+        std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b){return a.timestamp < b.timestamp;});
+    }
+
+    TraceReader::~TraceReader(){
+        if (memory) munmap(memory, size);
+    }
+}